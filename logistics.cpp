@@ -6,908 +6,8886 @@
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <cstdint>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <fstream>
+#include <unordered_map>
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <charconv>
+#include <deque>
+#include <set>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <atomic>
+#include <shared_mutex>
+#include <memory>
+#include <new>
+#include <memory_resource>
+#include <csignal>
+#include <cerrno>
+#include <cassert>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-// --- Inventory Class ---
-class Inventory {
+// --- SlotHandle Struct ---
+// Stable reference to a record in a SlotMap. The generation detects handles whose
+// record has since been erased (and whose slot may have been reused).
+struct SlotHandle {
+    uint32_t Index = numeric_limits<uint32_t>::max();
+    uint32_t Generation = 0;
+
+    bool operator==(const SlotHandle& other) const {
+        return Index == other.Index && Generation == other.Generation;
+    }
+    bool operator!=(const SlotHandle& other) const {
+        return !(*this == other);
+    }
+};
+
+// --- RecordView Class ---
+// Read-only range that borrows a repository's storage instead of copying it. A view
+// (and any page or filter taken from it) is valid until the repository is next modified.
+template <typename T>
+class RecordView {
+private:
+    const T* first = nullptr;
+    const T* last = nullptr;
+
 public:
-    int ItemId;
-    string ItemName;
-    string Category;
-    int Quantity;
-    string Location;
-    time_t LastUpdated;
+    // Lazily filtered range; iterating it skips records that fail the predicate.
+    template <typename Pred>
+    class Filtered {
+    private:
+        const T* first;
+        const T* last;
+        Pred pred;
 
-    Inventory(int id = 0, string name = "", string cat = "", int qty = 0, string loc = "")
-        : ItemId(id), ItemName(name), Category(cat), Quantity(qty), Location(loc), LastUpdated(time(nullptr)) {}
+    public:
+        class iterator {
+        private:
+            const T* cur;
+            const T* last;
+            const Pred* pred;
 
-    void display() const {
-        cout << "Item ID: " << ItemId << endl;
-        cout << "Name: " << ItemName << endl;
-        cout << "Category: " << Category << endl;
-        cout << "Quantity: " << Quantity << endl;
-        cout << "Location: " << Location << endl;
-        cout << "Last Updated: " << formatDate(LastUpdated) << endl;
-        cout << "-------------------------" << endl;
+            void skip() {
+                while (cur != last && !(*pred)(*cur)) ++cur;
+            }
+
+        public:
+            iterator(const T* c, const T* l, const Pred* p) : cur(c), last(l), pred(p) {
+                skip();
+            }
+            const T& operator*() const {
+                return *cur;
+            }
+            const T* operator->() const {
+                return cur;
+            }
+            iterator& operator++() {
+                ++cur;
+                skip();
+                return *this;
+            }
+            bool operator!=(const iterator& other) const {
+                return cur != other.cur;
+            }
+            bool operator==(const iterator& other) const {
+                return cur == other.cur;
+            }
+        };
+
+        Filtered(const T* f, const T* l, Pred p) : first(f), last(l), pred(move(p)) {}
+
+        iterator begin() const {
+            return iterator(first, last, &pred);
+        }
+        iterator end() const {
+            return iterator(last, last, &pred);
+        }
+
+        // Visits at most `limit` matches after skipping `offset` of them; returns how many were visited.
+        template <typename Fn>
+        size_t page(size_t offset, size_t limit, Fn fn) const {
+            size_t visited = 0;
+            for (const T& record : *this) {
+                if (offset > 0) {
+                    --offset;
+                    continue;
+                }
+                if (visited == limit) break;
+                fn(record);
+                ++visited;
+            }
+            return visited;
+        }
+    };
+
+    RecordView() = default;
+    RecordView(const T* f, const T* l) : first(f), last(l) {}
+
+    const T* begin() const {
+        return first;
+    }
+    const T* end() const {
+        return last;
+    }
+    size_t size() const {
+        return static_cast<size_t>(last - first);
+    }
+    bool empty() const {
+        return first == last;
+    }
+    const T& operator[](size_t i) const {
+        return first[i];
     }
 
-private:
-    string formatDate(time_t time) const {
-        tm t;
-#ifdef _MSC_VER
-        localtime_s(&t, &time);
-#else
-        localtime_r(&time, &t);
-#endif
-        stringstream ss;
-        ss << put_time(&t, "%Y-%m-%d %H:%M:%S");
-        return ss.str();
+    // O(1) slice of at most `limit` records starting at `offset`.
+    RecordView page(size_t offset, size_t limit) const {
+        size_t start = min(offset, size());
+        return RecordView(first + start, first + start + min(limit, size() - start));
+    }
+
+    template <typename Pred>
+    Filtered<Pred> where(Pred pred) const {
+        return Filtered<Pred>(first, last, move(pred));
     }
 };
 
-// --- InventoryManager Class ---
-class InventoryManager {
+// --- CountingResource Class ---
+// Memory resource that forwards to another and counts what passes through it, so the
+// allocation behaviour of a repository can be measured.
+class CountingResource : public pmr::memory_resource {
 private:
-    vector<Inventory> inventories;
-    int nextItemId = 1;
+    pmr::memory_resource* upstream;
+    atomic<uint64_t> allocations{0};
+    atomic<uint64_t> bytes{0};
+
+protected:
+    void* do_allocate(size_t size, size_t alignment) override {
+        allocations.fetch_add(1, memory_order_relaxed);
+        bytes.fetch_add(size, memory_order_relaxed);
+        return upstream->allocate(size, alignment);
+    }
+
+    void do_deallocate(void* p, size_t size, size_t alignment) override {
+        upstream->deallocate(p, size, alignment);
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
 
 public:
-    void addInventory() {
-        string name, category, location;
-        int quantity;
+    explicit CountingResource(pmr::memory_resource* next = pmr::get_default_resource()) : upstream(next) {}
 
-        cout << "Enter Item Name: ";
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        getline(cin, name);
+    uint64_t allocationCount() const {
+        return allocations.load(memory_order_relaxed);
+    }
 
-        cout << "Enter Category: ";
-        getline(cin, category);
+    uint64_t allocatedBytes() const {
+        return bytes.load(memory_order_relaxed);
+    }
+};
 
-        cout << "Enter Quantity: ";
-        cin >> quantity;
-        if (cin.fail()) {
-            cerr << "Invalid quantity input." << endl;
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return;
-        }
+// --- SlotMap Class ---
+// Generational slot map: O(1) insert and erase, records packed densely for
+// iteration, and handles that stay valid until their own record is erased.
+// Erasing moves the last record into the hole, so iteration order is not insertion order.
+// Raw pointers into the map are invalidated by any insert or erase; keep handles instead.
+template <typename T>
+class SlotMap {
+private:
+    static constexpr uint32_t NoSlot = numeric_limits<uint32_t>::max();
 
-        cout << "Enter Location: ";
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        getline(cin, location);
+    struct Slot {
+        uint32_t DenseIndex;  // next free slot while the slot is on the free list
+        uint32_t Generation;
+    };
+
+    pmr::vector<T> dense;
+    pmr::vector<uint32_t> denseToSlot;
+    pmr::vector<Slot> slots;
+    uint32_t freeHead = NoSlot;
+
+public:
+    explicit SlotMap(pmr::memory_resource* resource = pmr::get_default_resource())
+        : dense(resource), denseToSlot(resource), slots(resource) {}
 
-        inventories.emplace_back(nextItemId++, name, category, quantity, location);
-        cout << "Inventory item added successfully with ID: " << inventories.back().ItemId << endl;
+    // The resource the records come from; structures built alongside them share it.
+    pmr::memory_resource* resource() const {
+        return dense.get_allocator().resource();
     }
 
-    void viewInventory() const {
-        if (inventories.empty()) {
-            cout << "Inventory is empty." << endl;
-            return;
-        }
-        cout << "--- Inventory List ---" << endl;
-        for (const auto& item : inventories) {
-            item.display();
+    SlotHandle insert(T value) {
+        uint32_t slot;
+        if (freeHead != NoSlot) {
+            slot = freeHead;
+            freeHead = slots[slot].DenseIndex;
+        } else {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot{0, 0});
         }
+        slots[slot].DenseIndex = static_cast<uint32_t>(dense.size());
+        dense.push_back(move(value));
+        denseToSlot.push_back(slot);
+        return SlotHandle{slot, slots[slot].Generation};
     }
 
-    void searchInventory() const {
-        int itemId;
-        cout << "Enter Item ID to search: ";
-        cin >> itemId;
-        if (cin.fail()) {
-            cerr << "Invalid ID input." << endl;
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return;
+    bool contains(SlotHandle h) const {
+        return h.Index < slots.size() && slots[h.Index].Generation == h.Generation &&
+               slots[h.Index].DenseIndex < dense.size() && denseToSlot[slots[h.Index].DenseIndex] == h.Index;
+    }
+
+    T* get(SlotHandle h) {
+        return contains(h) ? &dense[slots[h.Index].DenseIndex] : nullptr;
+    }
+
+    const T* get(SlotHandle h) const {
+        return contains(h) ? &dense[slots[h.Index].DenseIndex] : nullptr;
+    }
+
+    bool erase(SlotHandle h) {
+        if (!contains(h)) return false;
+        uint32_t hole = slots[h.Index].DenseIndex;
+        uint32_t last = static_cast<uint32_t>(dense.size() - 1);
+        if (hole != last) {
+            dense[hole] = move(dense[last]);
+            denseToSlot[hole] = denseToSlot[last];
+            slots[denseToSlot[hole]].DenseIndex = hole;
         }
+        dense.pop_back();
+        denseToSlot.pop_back();
+        slots[h.Index].Generation++;
+        slots[h.Index].DenseIndex = freeHead;
+        freeHead = h.Index;
+        return true;
+    }
 
-        for (const auto& item : inventories) {
-            if (item.ItemId == itemId) {
-                cout << "--- Item Found ---" << endl;
-                item.display();
-                return;
+    // Position of the record in iteration order; only meaningful while contains(h).
+    size_t denseIndex(SlotHandle h) const {
+        return slots[h.Index].DenseIndex;
+    }
+
+    // Handle of whatever record occupies the slot now; get() on it returns nullptr if none does.
+    SlotHandle handleOfSlot(uint32_t slot) const {
+        return slot < slots.size() ? SlotHandle{slot, slots[slot].Generation} : SlotHandle();
+    }
+
+    SlotHandle handleAt(size_t denseIndex) const {
+        uint32_t slot = denseToSlot[denseIndex];
+        return SlotHandle{slot, slots[slot].Generation};
+    }
+
+    // Erases every record matching pred in one pass over the dense array.
+    template <typename Pred>
+    size_t eraseIf(Pred pred, function<void(const T&)> onErase = nullptr) {
+        size_t removed = 0;
+        size_t i = 0;
+        while (i < dense.size()) {
+            if (pred(dense[i])) {
+                if (onErase) onErase(dense[i]);
+                erase(handleAt(i));
+                removed++;
+            } else {
+                ++i;
             }
         }
-        cout << "Inventory item with ID " << itemId << " not found." << endl;
+        return removed;
     }
 
-    void editInventory() {
-        int itemId;
-        cout << "Enter Item ID to edit: ";
-        cin >> itemId;
-        if (cin.fail()) {
-            cerr << "Invalid ID input." << endl;
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return;
+    void reserve(size_t n) {
+        dense.reserve(n);
+        denseToSlot.reserve(n);
+        slots.reserve(n);
+    }
+
+    void clear() {
+        dense.clear();
+        denseToSlot.clear();
+        slots.clear();
+        freeHead = NoSlot;
+    }
+
+    RecordView<T> view() const {
+        return RecordView<T>(dense.data(), dense.data() + dense.size());
+    }
+
+    size_t size() const {
+        return dense.size();
+    }
+
+    bool empty() const {
+        return dense.empty();
+    }
+
+    // Bytes reserved for records and slots; heap storage owned by the records is not included.
+    size_t bytesUsed() const {
+        return dense.capacity() * sizeof(T) + denseToSlot.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(Slot);
+    }
+
+    typename pmr::vector<T>::const_iterator begin() const {
+        return dense.begin();
+    }
+
+    typename pmr::vector<T>::const_iterator end() const {
+        return dense.end();
+    }
+};
+
+// --- VersionedRecords Class ---
+// Copy-on-write shadow of a repository, keyed by slot index, that readers can pin.
+// Records live in fixed-size chunks shared between the live table and every snapshot
+// taken since the chunk last changed; a write to a shared chunk copies just that chunk.
+// Taking a snapshot copies only the chunk pointers, and a version is reclaimed when
+// its last snapshot is dropped. Writers must be serialised by the caller; snapshots
+// may be taken and scanned from any thread.
+template <typename T>
+class VersionedRecords {
+private:
+    static constexpr size_t ChunkSize = 256;
+
+    // Rows are raw storage: only slots with their Live bit set hold a constructed
+    // record, so a new chunk costs no record constructors and a copy touches only
+    // live rows.
+    struct Chunk {
+        array<uint64_t, ChunkSize / 64> Live{};
+        alignas(T) unsigned char Rows[ChunkSize * sizeof(T)];
+
+        Chunk() {}
+
+        Chunk(const Chunk& other) : Live(other.Live) {
+            other.forEachLive([this, &other](size_t i) { new (Rows + i * sizeof(T)) T(other.row(i)); });
         }
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-        for (auto& item : inventories) {
-            if (item.ItemId == itemId) {
-                cout << "--- Editing Item ID: " << itemId << " ---" << endl;
-                cout << "Enter new Item Name (" << item.ItemName << "): ";
-                string name;
-                getline(cin, name);
-                if (!name.empty()) item.ItemName = name;
-
-                cout << "Enter new Category (" << item.Category << "): ";
-                string category;
-                getline(cin, category);
-                if (!category.empty()) item.Category = category;
-
-                cout << "Enter new Quantity (" << item.Quantity << "): ";
-                int quantity;
-                cin >> quantity;
-                if (!cin.fail()) item.Quantity = quantity;
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        Chunk& operator=(const Chunk&) = delete;
+
+        ~Chunk() {
+            forEachLive([this](size_t i) { row(i).~T(); });
+        }
 
-                cout << "Enter new Location (" << item.Location << "): ";
-                string location;
-                getline(cin, location);
-                if (!location.empty()) item.Location = location;
+        bool live(size_t i) const {
+            return Live[i / 64] & (1ull << (i % 64));
+        }
 
-                item.LastUpdated = time(nullptr);
-                cout << "Inventory item with ID " << itemId << " updated." << endl;
-                return;
-            }
+        T& row(size_t i) {
+            return *launder(reinterpret_cast<T*>(Rows + i * sizeof(T)));
         }
-        cout << "Inventory item with ID " << itemId << " not found." << endl;
-    }
 
-    void deleteInventory() {
-        int itemId;
-        cout << "Enter Item ID to delete: ";
-        cin >> itemId;
-        if (cin.fail()) {
-            cerr << "Invalid ID input." << endl;
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return;
+        const T& row(size_t i) const {
+            return *launder(reinterpret_cast<const T*>(Rows + i * sizeof(T)));
         }
 
-        auto it = remove_if(inventories.begin(), inventories.end(),
-                                [itemId](const Inventory& inv){ return inv.ItemId == itemId; });
-        if (it != inventories.end()) {
-            inventories.erase(it, inventories.end());
-            cout << "Inventory item with ID " << itemId << " deleted." << endl;
+        template <typename Fn>
+        void forEachLive(Fn fn) const {
+            for (size_t word = 0; word < Live.size(); ++word) {
+                for (uint64_t bits = Live[word]; bits; bits &= bits - 1) {
+                    fn(word * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+                }
+            }
+        }
+    };
+
+    mutable mutex mtx;
+    pmr::vector<shared_ptr<Chunk>> chunks;
+    uint64_t version = 0;
+    size_t live = 0;
+    size_t copied = 0;
+
+    Chunk& writable(uint32_t slot) {
+        size_t c = slot / ChunkSize;
+        if (c >= chunks.size()) chunks.resize(c + 1);
+        shared_ptr<Chunk>& chunk = chunks[c];
+        if (!chunk) {
+            chunk = allocate_shared<Chunk>(chunks.get_allocator());
+        } else if (chunk.use_count() > 1) {
+            chunk = allocate_shared<Chunk>(chunks.get_allocator(), *chunk);
+            copied++;
         } else {
-            cout << "Inventory item with ID " << itemId << " not found." << endl;
+            // Pairs with the release in the last reader's shared_ptr decrement.
+            atomic_thread_fence(memory_order_acquire);
         }
+        return *chunk;
     }
 
-    void inventorySubMenu() {
-        int choice;
-        do {
-            cout << "\n--- Inventory Management ---" << endl;
-            cout << "1. Add Item" << endl;
-            cout << "2. View Items" << endl;
-            cout << "3. Search Item" << endl;
-            cout << "4. Edit Item" << endl;
-            cout << "5. Delete Item" << endl;
-            cout << "0. Back to Main Menu" << endl;
-            cout << "Enter your choice: ";
-            cin >> choice;
+public:
+    // Chunks come from `resource`, which must outlive every snapshot taken.
+    explicit VersionedRecords(pmr::memory_resource* resource = pmr::get_default_resource()) : chunks(resource) {}
 
-            if (cin.fail()) {
-                cerr << "Invalid input. Please enter a number." << endl;
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                choice = -1;
-                continue;
-            }
+    // A pinned version: immutable, safe to scan without any repository lock.
+    class Snapshot {
+    private:
+        vector<shared_ptr<const Chunk>> chunks;
+        uint64_t version = 0;
+        size_t count = 0;
 
-            switch (choice) {
-                case 1:
-                    addInventory();
-                    break;
-                case 2:
-                    viewInventory();
-                    break;
-                case 3:
-                    searchInventory();
-                    break;
-                case 4:
-                    editInventory();
-                    break;
-                case 5:
-                    deleteInventory();
-                    break;
-                case 0:
-                    cout << "Returning to Main Menu." << endl;
-                    break;
-                default:
-                    cout << "Invalid choice. Please try again." << endl;
+        friend class VersionedRecords;
+
+    public:
+        uint64_t versionNumber() const {
+            return version;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        // Calls fn for every record in the version, in slot order.
+        template <typename Fn>
+        void forEach(Fn fn) const {
+            for (const auto& chunk : chunks) {
+                if (chunk) chunk->forEachLive([&chunk, &fn](size_t i) { fn(chunk->row(i)); });
             }
-        } while (choice != 0);
+        }
+    };
+
+    void put(uint32_t slot, const T& record) {
+        lock_guard<mutex> lock(mtx);
+        Chunk& chunk = writable(slot);
+        size_t i = slot % ChunkSize;
+        if (chunk.live(i)) {
+            chunk.row(i) = record;
+        } else {
+            new (chunk.Rows + i * sizeof(T)) T(record);
+            chunk.Live[i / 64] |= 1ull << (i % 64);
+            live++;
+        }
+        version++;
     }
-};
 
-// --- Maintenance Class ---
-class Maintenance {
-public:
-    int ScheduleId;
-    int EquipmentId;
-    string Description;
-    time_t ScheduledDate;
-    string CompletionStatus;
+    void erase(uint32_t slot) {
+        lock_guard<mutex> lock(mtx);
+        Chunk& chunk = writable(slot);
+        size_t i = slot % ChunkSize;
+        if (chunk.live(i)) {
+            chunk.row(i).~T();
+            chunk.Live[i / 64] &= ~(1ull << (i % 64));
+            live--;
+        }
+        version++;
+    }
 
-    Maintenance(int scheduleId = 0, int equipmentId = 0, string description = "", time_t scheduledDate = 0, string completionStatus = "")
-        : ScheduleId(scheduleId), EquipmentId(equipmentId), Description(description), ScheduledDate(scheduledDate), CompletionStatus(completionStatus) {}
+    Snapshot snapshot() const {
+        Snapshot s;
+        lock_guard<mutex> lock(mtx);
+        s.chunks.assign(chunks.begin(), chunks.end());
+        s.version = version;
+        s.count = live;
+        return s;
+    }
 
-    void display() const {
-        cout << "Schedule ID: " << ScheduleId << endl;
-        cout << "Equipment ID: " << EquipmentId << endl;
-        cout << "Description: " << Description << endl;
-        cout << "Scheduled Date: " << formatDate(ScheduledDate) << endl;
-        cout << "Completion Status: " << CompletionStatus << endl;
-        cout << "-------------------------" << endl;
+    // Chunks copied because a snapshot still held them.
+    size_t copiedChunks() const {
+        lock_guard<mutex> lock(mtx);
+        return copied;
     }
 
-private:
-    string formatDate(time_t time) const {
-        tm t;
-#ifdef _MSC_VER
-        localtime_s(&t, &time);
-#else
-        localtime_r(&time, &t);
-#endif
-        stringstream ss;
-        ss << put_time(&t, "%Y-%m-%d %H:%M:%S");
-        return ss.str();
+    // Bytes of the chunks the live table points at; chunks only snapshots still hold
+    // are not included.
+    size_t bytesUsed() const {
+        lock_guard<mutex> lock(mtx);
+        size_t bytes = chunks.capacity() * sizeof(shared_ptr<Chunk>);
+        for (const auto& chunk : chunks) {
+            if (chunk) bytes += sizeof(Chunk);
+        }
+        return bytes;
     }
 };
 
-// --- MaintenanceRepository Class ---
-class MaintenanceRepository {
+// --- IdIndex Class ---
+// Open-addressing (linear probing) hash map from a record ID to its handle in a
+// repository's storage. Deletes use backward shifting, so there are no tombstones.
+class IdIndex {
 private:
-    vector<Maintenance> maintenances;
-    int nextScheduleId = 1;
+    static constexpr int EmptyKey = numeric_limits<int>::min();
 
-public:
-    bool scheduleMaintenance(Maintenance b) {
-        b.ScheduleId = nextScheduleId++;
-        maintenances.push_back(b);
-        return true;
+    // Key and handle share a bucket so a probe touches one cache line.
+    struct Entry {
+        int Key;
+        SlotHandle Handle;
+    };
+
+    pmr::vector<Entry> entries;
+    SlotHandle rejected;
+    size_t count = 0;
+    int shift = 64;
+
+    size_t bucketFor(int key) const {
+        return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ull) >> shift);
     }
 
-    bool updateSchedule(Maintenance b) {
-        for (auto& m : maintenances) {
-            if (m.ScheduleId == b.ScheduleId) {
-                m.EquipmentId = b.EquipmentId;
-                m.Description = b.Description;
-                m.ScheduledDate = b.ScheduledDate;
-                m.CompletionStatus = b.CompletionStatus;
-                return true;
-            }
-        }
-        return false;
+    size_t mask() const {
+        return entries.size() - 1;
     }
 
-    bool removeMaintenance(int scheduleId) {
-        auto it = remove_if(maintenances.begin(), maintenances.end(),
-                            [scheduleId](const Maintenance& m){ return m.ScheduleId == scheduleId; });
-        if (it != maintenances.end()) {
-            maintenances.erase(it, maintenances.end());
-            return true;
+    void rehash(size_t capacity) {
+        pmr::vector<Entry> old(capacity, Entry{EmptyKey, SlotHandle()}, entries.get_allocator());
+        old.swap(entries);
+        shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) shift--;
+        for (const Entry& e : old) {
+            if (e.Key == EmptyKey) continue;
+            size_t pos = bucketFor(e.Key);
+            while (entries[pos].Key != EmptyKey) pos = (pos + 1) & mask();
+            entries[pos] = e;
         }
-        return false;
     }
 
-    Maintenance* viewSchedule(int id) {
-        for (auto& m : maintenances) {
-            if (m.ScheduleId == id) {
-                return &m;
-            }
+    size_t position(int key) const {
+        if (entries.empty() || key == EmptyKey) return entries.size();
+        size_t pos = bucketFor(key);
+        while (entries[pos].Key != EmptyKey) {
+            if (entries[pos].Key == key) return pos;
+            pos = (pos + 1) & mask();
         }
-        return nullptr;
+        return entries.size();
     }
 
-    vector<Maintenance> viewAll() const {
-        return maintenances;
+public:
+    explicit IdIndex(pmr::memory_resource* resource = pmr::get_default_resource()) : entries(resource) {}
+
+    void reserve(size_t n) {
+        size_t capacity = 16;
+        while (capacity * 3 < n * 4) capacity <<= 1;
+        if (capacity > entries.size()) rehash(capacity);
     }
 
-    void maintenanceSubMenu() {
-        int choice;
-        do {
-            cout << "\n--- Maintenance Management ---" << endl;
-            cout << "1. Schedule Maintenance" << endl;
-            cout << "2. View All Schedules" << endl;
-            cout << "3. View Schedule Details" << endl;
-            cout << "4. Update Schedule" << endl;
-            cout << "5. Remove Schedule" << endl;
-            cout << "0. Back to Main Menu" << endl;
-            cout << "Enter your choice: ";
-            cin >> choice;
+    // Hints the key's bucket into cache ahead of a bulk insert or lookup.
+    void prefetch(int key) const {
+#if defined(__GNUC__)
+        if (!entries.empty()) __builtin_prefetch(&entries[bucketFor(key)]);
+#else
+        (void)key;
+#endif
+    }
 
-            if (cin.fail()) {
-                cerr << "Invalid input. Please enter a number." << endl;
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                choice = -1;
+    // Returns the handle slot for key, adding an empty one if absent. The reference
+    // is valid until the next insert or erase.
+    SlotHandle& slotFor(int key, bool& inserted) {
+        inserted = false;
+        if (key == EmptyKey) return rejected;
+        if ((count + 1) * 4 > entries.size() * 3) rehash(entries.empty() ? 16 : entries.size() * 2);
+        size_t pos = bucketFor(key);
+        while (entries[pos].Key != EmptyKey) {
+            if (entries[pos].Key == key) return entries[pos].Handle;
+            pos = (pos + 1) & mask();
+        }
+        entries[pos] = Entry{key, SlotHandle()};
+        count++;
+        inserted = true;
+        return entries[pos].Handle;
+    }
+
+    // Inserts the key or, if it is already present, repoints it at the new handle.
+    void insert(int key, SlotHandle handle) {
+        bool inserted;
+        slotFor(key, inserted) = handle;
+    }
+
+    const SlotHandle* find(int key) const {
+        size_t pos = position(key);
+        return pos == entries.size() ? nullptr : &entries[pos].Handle;
+    }
+
+    bool erase(int key) {
+        size_t hole = position(key);
+        if (hole == entries.size()) return false;
+        size_t next = hole;
+        while (true) {
+            next = (next + 1) & mask();
+            if (entries[next].Key == EmptyKey) break;
+            size_t home = bucketFor(entries[next].Key);
+            bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+            if (stays) continue;
+            entries[hole] = entries[next];
+            hole = next;
+        }
+        entries[hole].Key = EmptyKey;
+        count--;
+        return true;
+    }
+
+    void clear() {
+        fill(entries.begin(), entries.end(), Entry{EmptyKey, SlotHandle()});
+        count = 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t bytesUsed() const {
+        return entries.capacity() * sizeof(Entry);
+    }
+};
+
+// --- ByteWriter / ByteReader Classes ---
+// Little helpers for the journal's binary record encoding (host byte order).
+class ByteWriter {
+private:
+    string& out;
+
+public:
+    explicit ByteWriter(string& buffer) : out(buffer) {}
+
+    void putU8(uint8_t v) {
+        out.push_back(static_cast<char>(v));
+    }
+
+    void putI32(int32_t v) {
+        out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void putI64(int64_t v) {
+        out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void putString(string_view v) {
+        putI32(static_cast<int32_t>(v.size()));
+        out.append(v.data(), v.size());
+    }
+
+    void putString(const string& v) {
+        putString(string_view(v));
+    }
+};
+
+class ByteReader {
+private:
+    const char* cur;
+    const char* end;
+    bool valid = true;
+
+    bool take(void* dst, size_t n) {
+        if (!valid || static_cast<size_t>(end - cur) < n) {
+            valid = false;
+            return false;
+        }
+        memcpy(dst, cur, n);
+        cur += n;
+        return true;
+    }
+
+public:
+    ByteReader(const char* data, size_t size) : cur(data), end(data + size) {}
+
+    uint8_t getU8() {
+        uint8_t v = 0;
+        take(&v, sizeof(v));
+        return v;
+    }
+
+    int32_t getI32() {
+        int32_t v = 0;
+        take(&v, sizeof(v));
+        return v;
+    }
+
+    int64_t getI64() {
+        int64_t v = 0;
+        take(&v, sizeof(v));
+        return v;
+    }
+
+    string getString() {
+        int32_t n = getI32();
+        if (!valid || n < 0 || static_cast<size_t>(end - cur) < static_cast<size_t>(n)) {
+            valid = false;
+            return string();
+        }
+        string v(cur, static_cast<size_t>(n));
+        cur += n;
+        return v;
+    }
+
+    bool ok() const {
+        return valid;
+    }
+};
+
+// CRC-32 (IEEE 802.3 polynomial), table driven.
+uint32_t crc32(const char* data, size_t size) {
+    static const auto table = [] {
+        array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// --- ChangeStream Class ---
+// One change as consumers see it: the mutation's journal record (its JournalOp byte,
+// then the record in the journal encoding), stamped with a sequence number and the
+// time it was published in microseconds since the epoch.
+struct ChangeEvent {
+    uint64_t Sequence = 0;
+    int64_t TimeMicros = 0;
+    string Payload;
+};
+
+// What writers do about a subscriber that is a whole ring behind: Drop overwrites the
+// events it has not read (its next read reports the gap), Block waits for it to catch
+// up, but never longer than ChangeStream::MaxStall per event.
+enum class Backpressure : uint8_t { Drop = 1, Block };
+
+// Lock-free broadcast ring of change events. A writer claims consecutive 64-byte cells
+// with a compare-and-swap, fills them and publishes each with a release store of its
+// stamp; an event spans as many cells as its payload needs and its first cell is
+// published last. Readers take no lock: each keeps its own cursor and copies an event
+// seqlock-style, re-checking the stamps afterwards to see whether it was overwritten
+// meanwhile. Only Block subscribers hold writers up, and only while the ring is full.
+// A payload too large for the ring is kept out of line, by sequence, in a side table
+// that holds up to LargeBytes; its cell carries only the reference.
+// Sequence numbers are cell positions, so they increase but jump by the size of the
+// event before; they start where the constructor says, letting the application keep
+// them increasing across restarts.
+class ChangeStream {
+public:
+    static constexpr size_t DefaultCells = 1 << 16;
+    static constexpr chrono::milliseconds MaxStall{100};
+    static constexpr size_t MaxSubscribers = 16;
+    static constexpr uint64_t Latest = numeric_limits<uint64_t>::max();
+    static constexpr size_t LargeBytes = 64 << 20;
+
+    struct Stats {
+        uint64_t Published;
+        uint64_t Stalls;     // events whose writer had to wait for a Block subscriber
+        uint64_t Overruns;   // times a writer gave up waiting and overwrote unread events
+        uint64_t Large;      // events too large for the ring, kept out of line
+    };
+
+private:
+    static constexpr size_t CellWords = 7;
+    static constexpr size_t CellBytes = CellWords * sizeof(uint64_t);
+    static constexpr size_t HeadBytes = CellBytes - 2 * sizeof(uint64_t);  // after the time and length
+    static constexpr uint64_t OutOfLine = 1ull << 63;                        // length flag: payload in `large`
+
+    struct alignas(64) Cell {
+        atomic<uint64_t> Stamp{0};  // (position + 1) * 2, plus 1 in an event's first cell; 0 while rewritten
+        array<atomic<uint64_t>, CellWords> Words{};
+    };
+
+    struct alignas(64) Subscriber {
+        atomic<uint64_t> Cursor{0};   // first position not yet consumed
+        atomic<uint8_t> Mode{0};      // a Backpressure, or 0 for a free slot
+        atomic<bool> Overrun{false};  // writers stopped waiting for it; cleared once it is back in the ring
+    };
+
+    static constexpr uint8_t Reserved = 0xFF;
+
+    vector<Cell> cells;
+    uint64_t mask;
+    uint64_t first;
+    alignas(64) atomic<uint64_t> claimed;
+    alignas(64) atomic<int> blocking{0};
+    array<Subscriber, MaxSubscribers> subscribers;
+    atomic<uint64_t> published{0};
+    atomic<uint64_t> stalls{0};
+    atomic<uint64_t> overruns{0};
+    atomic<uint64_t> largeCount{0};
+
+    // Out-of-line payloads by sequence. Taken only for events that do not fit the ring;
+    // the oldest are dropped once they leave the ring or exceed LargeBytes, and a reader
+    // reaching a dropped one sees it as skipped.
+    mutable mutex largeMutex;
+    map<uint64_t, string> large;
+    size_t largeBytes = 0;
+
+    mutex waitMutex;
+    condition_variable waitCv;
+    atomic<int> sleepers{0};
+
+    static uint64_t stampOf(uint64_t position, bool head) {
+        return (position + 1) * 2 + (head ? 1 : 0);
+    }
+
+    static size_t ringSize(size_t cells) {
+        size_t size = 64;
+        while (size < cells) size <<= 1;
+        return size;
+    }
+
+    static size_t cellsFor(size_t bytes) {
+        return bytes <= HeadBytes ? 1 : 1 + (bytes - HeadBytes + CellBytes - 1) / CellBytes;
+    }
+
+    uint64_t oldest(uint64_t end) const {
+        return end - first > cells.size() ? end - cells.size() : first;
+    }
+
+    // Seqlock write: the stamp is cleared before the words change and set after.
+    void writeCell(uint64_t position, bool head, const array<uint64_t, CellWords>& words) {
+        Cell& cell = cells[position & mask];
+        cell.Stamp.store(0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        for (size_t i = 0; i < CellWords; ++i) cell.Words[i].store(words[i], memory_order_relaxed);
+        cell.Stamp.store(stampOf(position, head), memory_order_release);
+    }
+
+    // Whether every Block subscriber has consumed the events that cells up to `end`
+    // would overwrite. Past `deadline` a subscriber still in the way is marked overrun.
+    bool roomFor(uint64_t end, chrono::steady_clock::time_point deadline) {
+        if (blocking.load(memory_order_acquire) == 0 || end - first <= cells.size()) return true;
+        uint64_t needed = end - cells.size();
+        bool room = true;
+        for (Subscriber& s : subscribers) {
+            if (s.Mode.load(memory_order_acquire) != static_cast<uint8_t>(Backpressure::Block) ||
+                s.Cursor.load(memory_order_acquire) >= needed || s.Overrun.load(memory_order_relaxed)) {
                 continue;
             }
+            if (deadline != chrono::steady_clock::time_point() && chrono::steady_clock::now() >= deadline) {
+                s.Overrun.store(true, memory_order_relaxed);
+                overruns.fetch_add(1, memory_order_relaxed);
+            } else {
+                room = false;
+            }
+        }
+        return room;
+    }
 
-            switch (choice) {
-                case 1: {
-                    int equipmentId;
-                    string description, completionStatus;
-                    time_t scheduledDate = time(nullptr); // Default to now
+    // Claims `count` cells once Block subscribers have made room for them, so cells
+    // are only claimed when they are free to write.
+    uint64_t claim(size_t count) {
+        uint64_t at = claimed.load(memory_order_relaxed);
+        chrono::steady_clock::time_point deadline;
+        for (int spins = 0;; ++spins) {
+            if (roomFor(at + count, deadline)) {
+                if (claimed.compare_exchange_weak(at, at + count)) return at;
+                continue;
+            }
+            if (deadline == chrono::steady_clock::time_point()) {
+                stalls.fetch_add(1, memory_order_relaxed);
+                deadline = chrono::steady_clock::now() + MaxStall;
+            }
+            if (spins < 64) {
+                this_thread::yield();
+            } else {
+                this_thread::sleep_for(chrono::microseconds(50));
+            }
+            at = claimed.load(memory_order_relaxed);
+        }
+    }
+
+    // The first position some Block subscriber still has to read, or Latest.
+    uint64_t blockedFrom() const {
+        uint64_t from = Latest;
+        for (const Subscriber& s : subscribers) {
+            if (s.Mode.load(memory_order_acquire) == static_cast<uint8_t>(Backpressure::Block) && !s.Overrun.load(memory_order_relaxed)) {
+                from = min(from, s.Cursor.load(memory_order_acquire));
+            }
+        }
+        return from;
+    }
+
+    // Adds an out-of-line payload, dropping the oldest ones to stay within LargeBytes.
+    // Payloads a Block subscriber has yet to read are only dropped after MaxStall.
+    void storeLarge(uint64_t at, string_view payload) {
+        chrono::steady_clock::time_point deadline;
+        for (int spins = 0;; ++spins) {
+            {
+                lock_guard<mutex> lock(largeMutex);
+                uint64_t start = oldest(claimed.load(memory_order_relaxed));
+                uint64_t needed = blockedFrom();
+                bool late = deadline != chrono::steady_clock::time_point() && chrono::steady_clock::now() >= deadline;
+                while (!large.empty() && (large.begin()->first < start ||
+                                          (largeBytes + payload.size() > LargeBytes && (large.begin()->first < needed || late)))) {
+                    if (large.begin()->first >= max(start, needed)) overruns.fetch_add(1, memory_order_relaxed);
+                    largeBytes -= large.begin()->second.size();
+                    large.erase(large.begin());
+                }
+                if (large.empty() || largeBytes + payload.size() <= LargeBytes) {
+                    large.emplace(at, string(payload));
+                    largeBytes += payload.size();
+                    largeCount.fetch_add(1, memory_order_relaxed);
+                    return;
+                }
+            }
+            if (deadline == chrono::steady_clock::time_point()) {
+                stalls.fetch_add(1, memory_order_relaxed);
+                deadline = chrono::steady_clock::now() + MaxStall;
+            }
+            if (spins < 64) {
+                this_thread::yield();
+            } else {
+                this_thread::sleep_for(chrono::microseconds(50));
+            }
+        }
+    }
+
+public:
+    // `capacityCells` is rounded up to a power of two; events larger than an eighth of
+    // the ring are kept out of line.
+    explicit ChangeStream(size_t capacityCells = DefaultCells, uint64_t firstSequence = 1)
+        : cells(ringSize(capacityCells)),
+          mask(cells.size() - 1),
+          first(firstSequence),
+          claimed(firstSequence) {}
+
+    ChangeStream(const ChangeStream&) = delete;
+    ChangeStream& operator=(const ChangeStream&) = delete;
+
+    // Publishes one journal payload. Safe to call from any number of threads; events
+    // appear in the order their writers claimed cells.
+    void publish(string_view payload) {
+        size_t size = payload.size();
+        bool outOfLine = cellsFor(size) > cells.size() / 8;
+        size_t count = outOfLine ? 1 : cellsFor(size);
+        uint64_t at = claim(count);
+        if (outOfLine) storeLarge(at, payload);
+
+        array<uint64_t, CellWords> words;
+        for (size_t i = 1; i < count; ++i) {
+            size_t offset = HeadBytes + (i - 1) * CellBytes;
+            words.fill(0);
+            memcpy(words.data(), payload.data() + offset, min(CellBytes, size - offset));
+            writeCell(at + i, false, words);
+        }
+        words.fill(0);
+        words[0] = static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count());
+        words[1] = outOfLine ? size | OutOfLine : size;
+        if (!outOfLine) memcpy(words.data() + 2, payload.data(), min(HeadBytes, size));
+        writeCell(at, true, words);
+
+        published.fetch_add(1, memory_order_relaxed);
+        if (sleepers.load() > 0) {
+            lock_guard<mutex> lock(waitMutex);
+            waitCv.notify_all();
+        }
+    }
+
+    // Calls fn(const ChangeEvent&) for up to `limit` events from `cursor` on, in order,
+    // and moves cursor past them. A cursor older than the ring (or inside an event that
+    // was overwritten while being read) moves to the oldest event still held, and the
+    // positions jumped over are added to `skipped`. Stops early at an event still being
+    // written. Returns the number of events read.
+    template <typename Fn>
+    size_t read(uint64_t& cursor, size_t limit, uint64_t& skipped, Fn fn) const {
+        thread_local ChangeEvent event;
+        size_t count = 0;
+        uint64_t end = claimed.load(memory_order_acquire);
+        if (cursor > end) cursor = end;
+        while (count < limit && cursor < end) {
+            uint64_t start = oldest(end);
+            if (cursor < start) {
+                skipped += start - cursor;
+                cursor = start;
+                continue;
+            }
+            const Cell& lead = cells[cursor & mask];
+            uint64_t stamp = lead.Stamp.load(memory_order_acquire);
+            if (stamp < stampOf(cursor, false)) break;  // claimed, not yet published
+            if (stamp > stampOf(cursor, true)) {         // overwritten by a later lap
+                end = claimed.load(memory_order_acquire);
+                continue;
+            }
+            if (stamp == stampOf(cursor, false)) {  // the middle of an event
+                ++cursor;
+                continue;
+            }
+
+            uint64_t size = lead.Words[1].load(memory_order_relaxed);
+            event.TimeMicros = static_cast<int64_t>(lead.Words[0].load(memory_order_relaxed));
+            bool outOfLine = (size & OutOfLine) != 0;
+            size_t span = outOfLine ? 1 : cellsFor(size);
+            bool intact = span <= cells.size() / 8;
+            if (outOfLine) {
+                lock_guard<mutex> lock(largeMutex);
+                auto found = large.find(cursor);
+                if (found == large.end()) {  // dropped to stay within LargeBytes
+                    skipped += 1;
+                    cursor += 1;
+                    continue;
+                }
+                event.Payload = found->second;
+            } else if (intact) {
+                event.Payload.resize(size);
+                array<uint64_t, CellWords> words;
+                for (size_t i = 0; i < span; ++i) {
+                    const Cell& cell = cells[(cursor + i) & mask];
+                    for (size_t w = 0; w < CellWords; ++w) words[w] = cell.Words[w].load(memory_order_relaxed);
+                    size_t offset = i == 0 ? 0 : HeadBytes + (i - 1) * CellBytes;
+                    size_t bytes = min(i == 0 ? HeadBytes : CellBytes, size - offset);
+                    memcpy(&event.Payload[0] + offset, i == 0 ? words.data() + 2 : words.data(), bytes);
+                }
+            }
+            if (intact) {
+                atomic_thread_fence(memory_order_acquire);
+                for (size_t i = 0; i < span && intact; ++i) {
+                    intact = cells[(cursor + i) & mask].Stamp.load(memory_order_relaxed) == stampOf(cursor + i, i == 0);
+                }
+            }
+            if (!intact) {
+                end = claimed.load(memory_order_acquire);
+                continue;
+            }
+            event.Sequence = cursor;
+            cursor += span;
+            count++;
+            fn(static_cast<const ChangeEvent&>(event));
+        }
+        return count;
+    }
+
+    // Registers a subscriber whose cursor starts at sequence `from`, or at the next
+    // event for Latest. Returns its ID, or -1 when MaxSubscribers are registered.
+    int subscribe(Backpressure mode, uint64_t from = Latest) {
+        for (size_t i = 0; i < MaxSubscribers; ++i) {
+            Subscriber& s = subscribers[i];
+            uint8_t expected = 0;
+            if (!s.Mode.compare_exchange_strong(expected, Reserved)) continue;
+            s.Cursor.store(from == Latest ? claimed.load() : from, memory_order_relaxed);
+            s.Overrun.store(false, memory_order_relaxed);
+            if (mode == Backpressure::Block) blocking.fetch_add(1);
+            s.Mode.store(static_cast<uint8_t>(mode), memory_order_release);
+            return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    void unsubscribe(int id) {
+        Subscriber& s = subscribers[static_cast<size_t>(id)];
+        if (s.Mode.exchange(0) == static_cast<uint8_t>(Backpressure::Block)) blocking.fetch_sub(1);
+    }
+
+    uint64_t position(int id) const {
+        return subscribers[static_cast<size_t>(id)].Cursor.load(memory_order_relaxed);
+    }
+
+    // Marks everything before `cursor` consumed, letting Block writers reuse its cells.
+    void advance(int id, uint64_t cursor) {
+        Subscriber& s = subscribers[static_cast<size_t>(id)];
+        s.Cursor.store(cursor, memory_order_release);
+        if (s.Overrun.load(memory_order_relaxed) && cursor + cells.size() >= claimed.load(memory_order_relaxed)) {
+            s.Overrun.store(false, memory_order_relaxed);
+        }
+    }
+
+    // Sleeps until a change at or after `cursor` is claimed, or the timeout passes.
+    void waitFor(uint64_t cursor, chrono::milliseconds timeout) {
+        sleepers.fetch_add(1);
+        {
+            unique_lock<mutex> lock(waitMutex);
+            waitCv.wait_for(lock, timeout, [this, cursor] { return claimed.load() > cursor; });
+        }
+        sleepers.fetch_sub(1);
+    }
+
+    // The sequence the next event will get.
+    uint64_t head() const {
+        return claimed.load(memory_order_acquire);
+    }
+
+    Stats stats() const {
+        return {published.load(memory_order_relaxed), stalls.load(memory_order_relaxed), overruns.load(memory_order_relaxed),
+                largeCount.load(memory_order_relaxed)};
+    }
+};
+
+// --- Journal Class ---
+enum class JournalOp : uint8_t {
+    AddInventory = 1,
+    EditInventory,
+    DeleteInventory,
+    ScheduleMaintenance,
+    UpdateSchedule,
+    RemoveMaintenance,
+    GenerateReport,
+    ReceiveShipment,
+    DispatchShipment,
+    RemoveShipment,
+    ExpireShipments,
+    AllocateSpace,
+    UpdateSpace,
+    FreeSpace,
+    ApplyBatch
+};
+
+// How long a mutation waits for its journal record to reach the disk:
+// None only hands records to the OS, Group waits for an fsync shared with every
+// writer that arrived meanwhile, Interval fsyncs in the background every few ms.
+enum class Durability { None, Group, Interval };
+
+// Append-only write-ahead journal. Each record is [length][crc32][op][payload];
+// the file starts with a header carrying the journal epoch, which snapshots use to
+// tell which journals they already contain. With a ChangeStream attached, every
+// record is also published there as a change event once it is committed, in journal
+// order, by the thread that flushed it.
+class Journal {
+public:
+    static constexpr char MagicBytes[8] = {'L', 'G', 'J', 'R', 'N', 'L', '\0', '\0'};
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t HeaderSize = 24;
+
+private:
+    string path;
+    FILE* file = nullptr;
+    uint64_t currentEpoch = 0;
+    Durability durability = Durability::Group;
+    chrono::milliseconds interval{10};
+
+    mutex mtx;
+    condition_variable cv;
+    string pending;
+    uint64_t appendedLsn = 0;
+    uint64_t writtenLsn = 0;
+    uint64_t durableLsn = 0;
+    uint64_t fileBytes = 0;
+    uint64_t syncCount = 0;
+    bool flushing = false;
+    bool stopping = false;
+    thread syncer;
+    ChangeStream* changes = nullptr;
+
+    static thread_local uint64_t lastLsn;
+    static thread_local int deferDepth;
+
+    bool openFile() {
+        file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        char header[HeaderSize] = {};
+        memcpy(header, MagicBytes, sizeof(MagicBytes));
+        memcpy(header + 8, &Version, sizeof(Version));
+        memcpy(header + 16, &currentEpoch, sizeof(currentEpoch));
+        fileBytes = HeaderSize;
+        return fwrite(header, 1, HeaderSize, file) == HeaderSize && syncFile();
+    }
+
+    bool syncFile() {
+        if (fflush(file) != 0) return false;
+#ifndef _WIN32
+        return fsync(fileno(file)) == 0;
+#else
+        return true;
+#endif
+    }
+
+    // Writes everything appended so far; only one thread flushes at a time, and
+    // the lock is released during the I/O so other writers can keep appending.
+    void flushLocked(unique_lock<mutex>& lock, bool sync) {
+        flushing = true;
+        string batch;
+        batch.swap(pending);
+        uint64_t target = appendedLsn;
+        lock.unlock();
+        bool ok = batch.empty() || fwrite(batch.data(), 1, batch.size(), file) == batch.size();
+        ok = ok && (sync ? syncFile() : fflush(file) == 0);
+        lock.lock();
+        if (!ok) cerr << "Journal write to " << path << " failed." << endl;
+        writtenLsn = max(writtenLsn, target);
+        if (sync) {
+            durableLsn = max(durableLsn, target);
+            syncCount++;
+        }
+        // Only Durability::None flushes without a sync, so the whole batch is now
+        // committed. It is published before its writers are released, so a change is
+        // in the stream by the time its commit returns; `flushing` holds the next flush,
+        // and so the next batch of events, back until then.
+        if (ok && changes && !batch.empty()) {
+            lock.unlock();
+            publishBatch(batch);
+            lock.lock();
+        }
+        flushing = false;
+        cv.notify_all();
+    }
+
+    void publishBatch(const string& batch) {
+        for (size_t at = 0; at + 2 * sizeof(uint32_t) <= batch.size();) {
+            uint32_t length;
+            memcpy(&length, batch.data() + at, sizeof(length));
+            at += 2 * sizeof(uint32_t);
+            changes->publish(string_view(batch.data() + at, length));
+            at += length;
+        }
+    }
+
+    void syncLoop() {
+        unique_lock<mutex> lock(mtx);
+        while (!stopping) {
+            cv.wait_for(lock, interval);
+            if (!flushing && durableLsn < appendedLsn) flushLocked(lock, true);
+        }
+    }
+
+    uint64_t appendPayload(const string& payload) {
+        uint32_t length = static_cast<uint32_t>(payload.size());
+        uint32_t checksum = crc32(payload.data(), payload.size());
+        lock_guard<mutex> lock(mtx);
+        pending.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        pending.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        pending.append(payload);
+        fileBytes += sizeof(length) + sizeof(checksum) + payload.size();
+        lastLsn = ++appendedLsn;
+        return lastLsn;
+    }
+
+    // Per-thread encode buffer, so logging a record does not allocate.
+    static string& scratchPayload(JournalOp op) {
+        thread_local string payload;
+        payload.assign(1, static_cast<char>(op));
+        return payload;
+    }
+
+    void finishAppend(uint64_t lsn) {
+        if (deferDepth == 0) commit(lsn);
+    }
+
+public:
+    // Defers the commit wait of every record this thread appends until the scope
+    // ends, so callers can release their locks before waiting on the disk.
+    class DeferredCommit {
+    private:
+        Journal* journal;
+
+    public:
+        explicit DeferredCommit(Journal* j) : journal(j) {
+            deferDepth++;
+        }
+        ~DeferredCommit() {
+            deferDepth--;
+            if (journal && deferDepth == 0 && lastLsn) journal->commit(lastLsn);
+        }
+    };
+
+    ~Journal() {
+        close();
+    }
+
+    // Starts a fresh journal file for the given epoch, replacing any old one.
+    bool open(const string& journalPath, uint64_t epoch, Durability mode, chrono::milliseconds syncInterval) {
+        close();
+        path = journalPath;
+        currentEpoch = epoch;
+        durability = mode;
+        interval = syncInterval;
+        stopping = false;
+        if (!openFile()) {
+            cerr << "Cannot open journal " << path << endl;
+            return false;
+        }
+        if (durability == Durability::Interval) syncer = thread(&Journal::syncLoop, this);
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (syncer.joinable()) syncer.join();
+        if (!file) return;
+        unique_lock<mutex> lock(mtx);
+        while (flushing) cv.wait(lock);
+        flushLocked(lock, true);
+        fclose(file);
+        file = nullptr;
+    }
+
+    template <typename T>
+    void log(JournalOp op, const T& record) {
+        string& payload = scratchPayload(op);
+        ByteWriter out(payload);
+        record.writeTo(out);
+        finishAppend(appendPayload(payload));
+    }
+
+    void logId(JournalOp op, int id) {
+        string& payload = scratchPayload(op);
+        ByteWriter(payload).putI32(id);
+        finishAppend(appendPayload(payload));
+    }
+
+    void logText(JournalOp op, const string& text) {
+        string& payload = scratchPayload(op);
+        ByteWriter(payload).putString(text);
+        finishAppend(appendPayload(payload));
+    }
+
+    // Blocks until the record with this sequence number is as durable as the mode promises.
+    void commit(uint64_t lsn) {
+        unique_lock<mutex> lock(mtx);
+        if (!file) return;
+        switch (durability) {
+            case Durability::None:
+                // Waits out a flush in progress, which may not include this record, so
+                // the record is written (and published) before the caller goes on.
+                while (writtenLsn < lsn) {
+                    if (flushing) {
+                        cv.wait(lock);
+                    } else {
+                        flushLocked(lock, false);
+                    }
+                }
+                break;
+            case Durability::Interval:
+                break;
+            case Durability::Group:
+                while (durableLsn < lsn) {
+                    if (flushing) {
+                        cv.wait(lock);
+                    } else {
+                        flushLocked(lock, true);
+                    }
+                }
+                break;
+        }
+    }
+
+    // Seals the current file under rotatedPath and continues in a new file with the
+    // next epoch. Writers are blocked only for the final flush and the rename.
+    bool rotate(const string& rotatedPath) {
+        unique_lock<mutex> lock(mtx);
+        if (!file) return false;
+        while (flushing) cv.wait(lock);
+        flushLocked(lock, true);
+        fclose(file);
+        file = nullptr;
+        if (rename(path.c_str(), rotatedPath.c_str()) != 0) {
+            file = fopen(path.c_str(), "ab");
+            return false;
+        }
+        currentEpoch++;
+        if (!openFile()) {
+            cerr << "Cannot reopen journal " << path << endl;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t epoch() {
+        lock_guard<mutex> lock(mtx);
+        return currentEpoch;
+    }
+
+    uint64_t size() {
+        lock_guard<mutex> lock(mtx);
+        return fileBytes;
+    }
+
+    uint64_t syncs() {
+        lock_guard<mutex> lock(mtx);
+        return syncCount;
+    }
+
+    const string& filePath() const {
+        return path;
+    }
+
+    // Publishes every record logged from now on to `stream` as well, as it commits.
+    void attachChanges(ChangeStream* stream) {
+        changes = stream;
+    }
+
+    ChangeStream* changeStream() const {
+        return changes;
+    }
+};
+
+thread_local uint64_t Journal::lastLsn = 0;
+thread_local int Journal::deferDepth = 0;
+
+// --- StringDictionary Class ---
+// Process-wide interning table for low-cardinality text fields. Every distinct value
+// is stored once and identified by a dense uint32 code; code 0 is the empty string.
+// Strings live in fixed-size chunks that never move, so decoding a code is two loads
+// and takes no lock. Interning checks a small per-thread cache before the shared map.
+class StringDictionary {
+public:
+    static StringDictionary& shared() {
+        static StringDictionary dictionary;
+        return dictionary;
+    }
+
+    uint32_t intern(string_view value) {
+        if (value.empty()) return 0;
+        size_t hash = std::hash<string_view>()(value);
+        CacheEntry& cached = threadCache()[hash % ThreadCacheSize];
+        if (cached.Hash == hash && cached.Code != 0 && text(cached.Code) == value) return cached.Code;
+
+        uint32_t code = 0;
+        {
+            shared_lock<shared_mutex> lock(mutex);
+            auto it = codes.find(value);
+            if (it != codes.end()) code = it->second;
+        }
+        if (code == 0) {
+            lock_guard<shared_mutex> lock(mutex);
+            auto it = codes.find(value);
+            if (it != codes.end()) {
+                code = it->second;
+            } else {
+                code = append(value);
+                codes.emplace(text(code), code);
+            }
+        }
+        cached = CacheEntry{hash, code};
+        return code;
+    }
+
+    // Looks a value up without adding it; queries use this so unknown values stay out.
+    bool find(string_view value, uint32_t& code) {
+        if (value.empty()) {
+            code = 0;
+            return true;
+        }
+        shared_lock<shared_mutex> lock(mutex);
+        auto it = codes.find(value);
+        if (it == codes.end()) return false;
+        code = it->second;
+        return true;
+    }
+
+    const string& text(uint32_t code) const {
+        return chunks[code >> ChunkBits].load(memory_order_acquire)[code & (ChunkSize - 1)];
+    }
+
+    size_t size() const {
+        return count.load(memory_order_acquire);
+    }
+
+    ~StringDictionary() {
+        for (auto& chunk : chunks) delete[] chunk.load(memory_order_relaxed);
+    }
+
+private:
+    static constexpr uint32_t ChunkBits = 12;
+    static constexpr uint32_t ChunkSize = 1u << ChunkBits;
+    static constexpr uint32_t MaxChunks = 1u << 16;
+    static constexpr size_t ThreadCacheSize = 256;
+
+    struct CacheEntry {
+        size_t Hash = 0;
+        uint32_t Code = 0;
+    };
+
+    array<atomic<string*>, MaxChunks> chunks{};
+    atomic<uint32_t> count{0};
+    shared_mutex mutex;
+    unordered_map<string_view, uint32_t> codes;
+
+    StringDictionary() {
+        append(string_view());
+    }
+
+    static array<CacheEntry, ThreadCacheSize>& threadCache() {
+        static thread_local array<CacheEntry, ThreadCacheSize> cache{};
+        return cache;
+    }
+
+    // Called with the unique lock held (or from the constructor).
+    uint32_t append(string_view value) {
+        uint32_t code = count.load(memory_order_relaxed);
+        uint32_t chunk = code >> ChunkBits;
+        if (chunk >= MaxChunks) {
+            cerr << "String dictionary is full." << endl;
+            abort();
+        }
+        string* storage = chunks[chunk].load(memory_order_relaxed);
+        if (!storage) {
+            storage = new string[ChunkSize];
+            chunks[chunk].store(storage, memory_order_release);
+        }
+        storage[code & (ChunkSize - 1)].assign(value.data(), value.size());
+        count.store(code + 1, memory_order_release);
+        return code;
+    }
+};
+
+// A dictionary-encoded string: four bytes per field, equality by code, and implicit
+// decoding wherever a const string& is expected.
+class InternedString {
+private:
+    uint32_t Code = 0;
+
+public:
+    InternedString() = default;
+    InternedString(string_view value) : Code(StringDictionary::shared().intern(value)) {}
+    InternedString(const string& value) : InternedString(string_view(value)) {}
+    InternedString(const char* value) : InternedString(string_view(value)) {}
+
+    uint32_t code() const {
+        return Code;
+    }
+
+    const string& str() const {
+        return StringDictionary::shared().text(Code);
+    }
+
+    operator const string&() const {
+        return str();
+    }
+
+    bool empty() const {
+        return Code == 0;
+    }
+
+    friend bool operator==(InternedString a, InternedString b) {
+        return a.Code == b.Code;
+    }
+
+    friend bool operator!=(InternedString a, InternedString b) {
+        return a.Code != b.Code;
+    }
+
+    friend bool operator==(InternedString a, const string& b) {
+        return a.str() == b;
+    }
+
+    friend bool operator==(InternedString a, const char* b) {
+        return a.str() == b;
+    }
+
+    friend ostream& operator<<(ostream& out, InternedString value) {
+        return out << value.str();
+    }
+};
+
+// Characters a string keeps outside its own object; short strings fit inline.
+template <typename Alloc>
+size_t heapBytes(const basic_string<char, char_traits<char>, Alloc>& text) {
+    static const size_t inlineCapacity = basic_string<char, char_traits<char>, Alloc>().capacity();
+    return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+}
+
+// Approximate heap footprint of a std::set or std::map: each tree node carries the
+// value plus three links and a colour word.
+template <typename Tree>
+size_t nodeBytes(const Tree& tree) {
+    return tree.size() * (sizeof(typename Tree::value_type) + 4 * sizeof(void*));
+}
+
+// --- HeapString Class ---
+// Owning 8-byte reference to text too varied to intern (names, descriptions). The
+// string object and its characters come from one memory resource: repositories
+// adopt text into theirs, so record text is pooled and counted with the records.
+// Empty text takes no storage. Converts to string_view.
+class HeapString {
+private:
+    pmr::string* text = nullptr;
+
+    static pmr::string* make(string_view value, pmr::memory_resource* resource) {
+        void* block = resource->allocate(sizeof(pmr::string), alignof(pmr::string));
+        return new (block) pmr::string(value, resource);
+    }
+
+    static void release(pmr::string* value) {
+        pmr::memory_resource* resource = value->get_allocator().resource();
+        value->~basic_string();
+        resource->deallocate(value, sizeof(pmr::string), alignof(pmr::string));
+    }
+
+public:
+    HeapString() = default;
+    HeapString(string_view value, pmr::memory_resource* resource = pmr::get_default_resource())
+        : text(value.empty() ? nullptr : make(value, resource)) {}
+    HeapString(const string& value) : HeapString(string_view(value)) {}
+    HeapString(const char* value) : HeapString(string_view(value)) {}
+
+    // A copy shares the source's resource, so copies of stored records stay pooled.
+    HeapString(const HeapString& other) : text(other.text ? make(*other.text, other.resource()) : nullptr) {}
+
+    HeapString(HeapString&& other) noexcept : text(other.text) {
+        other.text = nullptr;
+    }
+
+    ~HeapString() {
+        if (text) release(text);
+    }
+
+    // Reuses the existing block when there is one, keeping its resource.
+    HeapString& operator=(const HeapString& other) {
+        if (this == &other) return *this;
+        if (!other.text) {
+            HeapString().swap(*this);
+        } else if (text) {
+            *text = *other.text;
+        } else {
+            text = make(*other.text, other.resource());
+        }
+        return *this;
+    }
+
+    HeapString& operator=(HeapString&& other) noexcept {
+        std::swap(text, other.text);
+        return *this;
+    }
+
+    HeapString& operator=(string_view value) {
+        if (value.empty()) {
+            HeapString().swap(*this);
+        } else if (text) {
+            text->assign(value.data(), value.size());
+        } else {
+            text = make(value, pmr::get_default_resource());
+        }
+        return *this;
+    }
+
+    HeapString& operator=(const string& value) {
+        return *this = string_view(value);
+    }
+
+    HeapString& operator=(const char* value) {
+        return *this = string_view(value);
+    }
+
+    void swap(HeapString& other) noexcept {
+        std::swap(text, other.text);
+    }
+
+    // Moves the text into `target` unless it is already there.
+    void adopt(pmr::memory_resource* target) {
+        if (text && resource() != target) HeapString(*text, target).swap(*this);
+    }
+
+    pmr::memory_resource* resource() const {
+        return text ? text->get_allocator().resource() : nullptr;
+    }
+
+    string_view str() const {
+        return text ? string_view(*text) : string_view();
+    }
+
+    operator string_view() const {
+        return str();
+    }
+
+    bool empty() const {
+        return !text;
+    }
+
+    // The string object plus any characters outside it.
+    size_t bytesUsed() const {
+        return text ? sizeof(pmr::string) + heapBytes(*text) : 0;
+    }
+
+    friend bool operator==(const HeapString& a, const string& b) {
+        return a.str() == b;
+    }
+
+    friend ostream& operator<<(ostream& out, const HeapString& value) {
+        return out << value.str();
+    }
+};
+
+// --- AttributeIndex Class ---
+// Secondary index from a dictionary code to the records carrying it. Each posting list
+// is unordered; a record's position in its list is tracked by slot index, so adding
+// and removing a record are O(1) swaps rather than searches.
+class AttributeIndex {
+public:
+    struct Posting {
+        int Id;
+        SlotHandle Handle;
+    };
+
+    explicit AttributeIndex(pmr::memory_resource* resource = pmr::get_default_resource())
+        : lists(resource), positions(resource), live(resource), groups(resource) {}
+
+    void add(uint32_t code, int id, SlotHandle h) {
+        if (code >= lists.size()) {
+            lists.resize(code + 1);
+            groups.resize(code + 1);
+        }
+        if (h.Index >= positions.size()) positions.resize(h.Index + 1);
+        if (lists[code].empty()) {
+            groups[code] = static_cast<uint32_t>(live.size());
+            live.push_back(code);
+        }
+        positions[h.Index] = static_cast<uint32_t>(lists[code].size());
+        lists[code].push_back(Posting{id, h});
+    }
+
+    void remove(uint32_t code, SlotHandle h) {
+        pmr::vector<Posting>& list = lists[code];
+        uint32_t position = positions[h.Index];
+        if (position + 1 != list.size()) {
+            list[position] = list.back();
+            positions[list[position].Handle.Index] = position;
+        }
+        list.pop_back();
+        if (list.empty()) {
+            uint32_t moved = live.back();
+            live[groups[code]] = moved;
+            groups[moved] = groups[code];
+            live.pop_back();
+        }
+    }
+
+    void update(uint32_t from, uint32_t to, int id, SlotHandle h) {
+        if (from == to) return;
+        remove(from, h);
+        add(to, id, h);
+    }
+
+    const pmr::vector<Posting>& postings(uint32_t code) const {
+        static const pmr::vector<Posting> none;
+        return code < lists.size() ? lists[code] : none;
+    }
+
+    // Codes with at least one posting, in no particular order. group(code) is the
+    // code's position here, so per-group tallies need no pass over the dictionary.
+    const pmr::vector<uint32_t>& codes() const {
+        return live;
+    }
+
+    uint32_t group(uint32_t code) const {
+        return groups[code];
+    }
+
+    void reserve(size_t n) {
+        positions.reserve(n);
+    }
+
+    void clear() {
+        lists.clear();
+        positions.clear();
+        live.clear();
+        groups.clear();
+    }
+
+    size_t bytesUsed() const {
+        size_t bytes = lists.capacity() * sizeof(pmr::vector<Posting>) +
+                       (positions.capacity() + live.capacity() + groups.capacity()) * sizeof(uint32_t);
+        for (const auto& list : lists) bytes += list.capacity() * sizeof(Posting);
+        return bytes;
+    }
+
+private:
+    pmr::vector<pmr::vector<Posting>> lists;
+    pmr::vector<uint32_t> positions;
+    pmr::vector<uint32_t> live;
+    pmr::vector<uint32_t> groups;
+};
+
+// --- ReferenceIndex Class ---
+// Reverse index from a referenced record's ID to the records pointing at it, such as
+// an item to its open shipments. The referring records form a doubly linked chain
+// threaded through their slot indexes, with the chain heads in an IdIndex, so linking,
+// unlinking and the "is anything pointing here" check are O(1) and allocation-free.
+class ReferenceIndex {
+public:
+    using Posting = AttributeIndex::Posting;
+
+    explicit ReferenceIndex(pmr::memory_resource* resource = pmr::get_default_resource())
+        : heads(resource), links(resource) {}
+
+    void add(int target, int id, SlotHandle h) {
+        if (h.Index >= links.size()) links.resize(h.Index + 1);
+        bool inserted = false;
+        SlotHandle& head = heads.slotFor(target, inserted);
+        uint32_t next = inserted ? None : head.Index;
+        links[h.Index] = Link{id, h.Generation, None, next};
+        if (next != None) links[next].Prev = h.Index;
+        head = h;
+    }
+
+    void remove(int target, SlotHandle h) {
+        const Link& link = links[h.Index];
+        if (link.Next != None) links[link.Next].Prev = link.Prev;
+        if (link.Prev != None) {
+            links[link.Prev].Next = link.Next;
+        } else if (link.Next != None) {
+            heads.insert(target, handle(link.Next));
+        } else {
+            heads.erase(target);
+        }
+    }
+
+    bool contains(int target) const {
+        return heads.find(target) != nullptr;
+    }
+
+    // Calls fn with a Posting for each record pointing at target, newest first.
+    template <typename Fn>
+    size_t forEach(int target, Fn fn) const {
+        const SlotHandle* head = heads.find(target);
+        size_t count = 0;
+        for (uint32_t i = head ? head->Index : None; i != None; i = links[i].Next, ++count) {
+            fn(Posting{links[i].Id, handle(i)});
+        }
+        return count;
+    }
+
+    void reserve(size_t n) {
+        links.reserve(n);
+    }
+
+    // Sizes the chain heads for `n` distinct targets.
+    void reserveTargets(size_t n) {
+        heads.reserve(n);
+    }
+
+    void prefetch(int target) const {
+        heads.prefetch(target);
+    }
+
+    void clear() {
+        heads.clear();
+        links.clear();
+    }
+
+    size_t bytesUsed() const {
+        return heads.bytesUsed() + links.capacity() * sizeof(Link);
+    }
+
+private:
+    static constexpr uint32_t None = numeric_limits<uint32_t>::max();
+
+    struct Link {
+        int Id;
+        uint32_t Generation;
+        uint32_t Prev;
+        uint32_t Next;
+    };
+
+    IdIndex heads;
+    pmr::vector<Link> links;
+
+    SlotHandle handle(uint32_t index) const {
+        return SlotHandle{index, links[index].Generation};
+    }
+};
+
+// --- NameIndex Class ---
+// Search index over item names. Names are normalized (ASCII lowercased, any other ASCII
+// character read as a word break) and split into words. Every indexed name is a
+// document with the next document number, so each word's document list is append-only
+// and ascending, and a per-document list of word IDs lets matches be checked and ranked
+// without touching the records. The vocabulary is itself indexed by trigrams, so
+// prefix, substring and typo-tolerant lookups expand each query word into vocabulary
+// words, walk the documents of the cheapest query word and filter them against a
+// bitmap of each other word's documents. Renaming or deleting an item retires its
+// document; the lists are compacted once retired documents outnumber live ones.
+enum class NameMatch : uint8_t { Prefix, Substring, Fuzzy };
+
+class NameIndex {
+public:
+    struct Hit {
+        uint32_t Slot;
+        double Score;
+        uint32_t Length;
+    };
+
+    explicit NameIndex(pmr::memory_resource* upstream = pmr::get_default_resource())
+        : resource(upstream), text(upstream), words(upstream), liveDocsOf(upstream), table(upstream), grams(upstream), docs(upstream),
+          forward(upstream), slotDocs(upstream) {}
+
+    void add(uint32_t slot, string_view name) {
+        if (slot >= slotDocs.size()) slotDocs.resize(slot + 1, NoDoc);
+        normalize(name, scratch);
+        uint32_t doc = static_cast<uint32_t>(docs.size());
+        uint32_t first = static_cast<uint32_t>(forward.size());
+        string_view normalized = scratch;
+        for (size_t start = 0; start < normalized.size();) {
+            size_t end = min(normalized.find(' ', start), normalized.size());
+            forward.push_back(wordFor(normalized.substr(start, end - start)));
+            start = end + 1;
+        }
+        docs.push_back(Doc{slot, first, static_cast<uint32_t>(forward.size()) - first, static_cast<uint32_t>(normalized.size())});
+        forEachWord(doc, [this, doc](uint32_t id) {
+            words[id].Docs.push_back(doc);
+            liveDocsOf[id]++;
+        });
+        slotDocs[slot] = doc;
+        liveDocs++;
+    }
+
+    void remove(uint32_t slot) {
+        if (slot >= slotDocs.size() || slotDocs[slot] == NoDoc) return;
+        uint32_t doc = slotDocs[slot];
+        forEachWord(doc, [this](uint32_t id) { liveDocsOf[id]--; });
+        docs[doc].Slot = NoSlot;
+        slotDocs[slot] = NoDoc;
+        liveDocs--;
+        if (++retiredDocs > liveDocs && retiredDocs >= CompactAfter) compact();
+    }
+
+    // The best `limit` matches, best first. Prefix matches names starting with the
+    // query and Substring names containing it; both rank whole-name, then name-start,
+    // then word-start matches first. Fuzzy matches names having, for every query word,
+    // a word within a few edits (one for words of three to five characters, two for
+    // longer ones) or, for the last query word, a word it starts; fewer edits rank
+    // first. Shorter names win ties.
+    vector<Hit> search(string_view query, NameMatch mode, size_t limit) const {
+        string q;
+        normalize(query, q);
+        vector<string_view> parts = split(q);
+        if (parts.empty() || limit == 0) return {};
+
+        vector<Term> plan(parts.size());
+        size_t driver = 0;
+        for (size_t i = 0; i < parts.size(); ++i) {
+            plan[i].Text = parts[i];
+            plan[i].Kind = roleOf(mode, i, parts.size());
+            plan[i].Last = i + 1 == parts.size();
+            plan[i].MaxEdits = mode == NameMatch::Fuzzy ? maxEdits(parts[i]) : 0;
+            matchWords(plan[i]);
+            if (plan[i].Words.empty()) return {};
+            if (walkCost(plan[i]) < walkCost(plan[driver])) driver = i;
+        }
+
+        vector<uint32_t> candidates;
+        for (uint32_t id : plan[driver].Words) {
+            candidates.insert(candidates.end(), words[id].Docs.begin(), words[id].Docs.end());
+        }
+        if (plan[driver].Words.size() > 1) {
+            sort(candidates.begin(), candidates.end());
+            candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+        }
+        // Terms whose lists are dense next to the candidates filter them through a bitmap,
+        // most selective first; once few candidates are left, the remaining terms are
+        // cheaper to check on each candidate's words.
+        vector<size_t> order;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            if (i != driver && plan[i].Words.size() <= MaxFilterWords) order.push_back(i);
+        }
+        sort(order.begin(), order.end(), [&plan](size_t a, size_t b) { return plan[a].Postings < plan[b].Postings; });
+        vector<uint64_t>& listed = buffers().Listed;
+        if (listed.size() < docs.size() / 64 + 1) listed.resize(docs.size() / 64 + 1, 0);
+        for (size_t i : order) {
+            if (plan[i].Postings > candidates.size() * FilterGap) break;
+            for (uint32_t id : plan[i].Words) {
+                for (uint32_t doc : words[id].Docs) listed[doc >> 6] |= 1ull << (doc & 63);
+            }
+            candidates.erase(remove_if(candidates.begin(), candidates.end(),
+                                       [&listed](uint32_t doc) { return !(listed[doc >> 6] >> (doc & 63) & 1); }),
+                             candidates.end());
+            for (uint32_t id : plan[i].Words) {
+                for (uint32_t doc : words[id].Docs) listed[doc >> 6] = 0;
+            }
+        }
+
+        // Bounded heap with the weakest kept hit on top.
+        vector<Hit> best;
+        for (size_t c = 0; c < candidates.size(); ++c) {
+#if defined(__GNUC__)
+            if (c + 8 < candidates.size()) __builtin_prefetch(&docs[candidates[c + 8]]);
+            if (c + 4 < candidates.size()) __builtin_prefetch(&forward[docs[candidates[c + 4]].Forward]);
+#endif
+            const Doc& d = docs[candidates[c]];
+            if (d.Slot == NoSlot) continue;
+            double score = mode == NameMatch::Fuzzy ? fuzzyScore(d, plan) : textScore(d, plan, mode);
+            if (score < 0) continue;
+            Hit hit{d.Slot, score, d.Length};
+            if (best.size() < limit) {
+                best.push_back(hit);
+                push_heap(best.begin(), best.end(), ranksBefore);
+            } else if (ranksBefore(hit, best.front())) {
+                pop_heap(best.begin(), best.end(), ranksBefore);
+                best.back() = hit;
+                push_heap(best.begin(), best.end(), ranksBefore);
+            }
+        }
+        sort_heap(best.begin(), best.end(), ranksBefore);
+        return best;
+    }
+
+    // Lowercases ASCII letters, turns every other ASCII character except digits into a
+    // word break and collapses breaks into single spaces. Bytes above 0x7F are kept.
+    static void normalize(string_view value, string& out) {
+        out.clear();
+        bool pendingBreak = false;
+        for (unsigned char c : value) {
+            if (c >= 0x80 || isalnum(c)) {
+                if (pendingBreak && !out.empty()) out += ' ';
+                pendingBreak = false;
+                out += static_cast<char>(c < 0x80 ? tolower(c) : c);
+            } else {
+                pendingBreak = true;
+            }
+        }
+    }
+
+    void reserve(size_t n) {
+        docs.reserve(n);
+        slotDocs.reserve(n);
+    }
+
+    void clear() {
+        text.clear();
+        words.clear();
+        liveDocsOf.clear();
+        table.clear();
+        grams.clear();
+        docs.clear();
+        forward.clear();
+        slotDocs.clear();
+        liveDocs = retiredDocs = 0;
+    }
+
+    size_t vocabularySize() const {
+        return words.size();
+    }
+
+    size_t bytesUsed() const {
+        size_t bytes = text.capacity() + words.capacity() * sizeof(Word) + table.capacity() * sizeof(uint32_t) +
+                       grams.capacity() * sizeof(pmr::vector<uint32_t>) + docs.capacity() * sizeof(Doc) +
+                       (liveDocsOf.capacity() + forward.capacity() + slotDocs.capacity()) * sizeof(uint32_t);
+        for (const Word& w : words) bytes += w.Docs.capacity() * sizeof(uint32_t);
+        for (const auto& list : grams) bytes += list.capacity() * sizeof(uint32_t);
+        return bytes;
+    }
+
+private:
+    static constexpr size_t Symbols = 38;  // space, a-z, 0-9, any other byte
+    static constexpr size_t GramCount = Symbols * Symbols * Symbols;
+    static constexpr size_t CompactAfter = 4096;
+    static constexpr size_t FuzzyBudget = 512;    // vocabulary words checked for two-edit matches per term
+    static constexpr size_t GramBudget = 16384;   // trigram list entries read to find them
+    static constexpr size_t MaxFilterWords = 16;  // broader terms are checked per candidate instead
+    static constexpr size_t FilterGap = 16;       // ... as are lists this many times longer than the candidates
+    static constexpr size_t MaxWord = 64;         // longer words are compared on their first 64 bytes
+    static constexpr uint32_t NoWord = numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NoDoc = numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NoSlot = numeric_limits<uint32_t>::max();
+
+    struct Word {
+        uint32_t Offset;
+        uint32_t Length;
+        pmr::vector<uint32_t> Docs;  // ascending; may include retired documents
+    };
+
+    // One indexed name: its record slot (NoSlot once retired) and its words in forward[].
+    struct Doc {
+        uint32_t Slot;
+        uint32_t Forward;
+        uint32_t Count;
+        uint32_t Length;
+    };
+
+    enum class Role { Exact, Prefix, Suffix, Contains, Near };
+
+    struct Term {
+        string_view Text;
+        Role Kind;
+        bool Last;
+        size_t MaxEdits;
+        vector<uint32_t> Words;      // ascending vocabulary IDs
+        vector<uint64_t> Members;    // the same words as a bitmap over the vocabulary
+        vector<uint8_t> Distances;   // edits per word, for fuzzy terms
+        size_t Postings = 0;
+
+        bool has(uint32_t id) const {
+            return Members[id >> 6] >> (id & 63) & 1;
+        }
+    };
+
+    pmr::memory_resource* resource;
+    pmr::string text;                          // every vocabulary word, back to back
+    pmr::vector<Word> words;
+    pmr::vector<uint32_t> liveDocsOf;          // per word; kept out of Word so broad terms expand cheaply
+    pmr::vector<uint32_t> table;               // open-addressed word IDs plus one; 0 is empty
+    pmr::vector<pmr::vector<uint32_t>> grams;  // trigram of "  word " to word IDs, ascending
+    pmr::vector<Doc> docs;
+    pmr::vector<uint32_t> forward;
+    pmr::vector<uint32_t> slotDocs;
+    size_t liveDocs = 0;
+    size_t retiredDocs = 0;
+    string scratch, padded;                    // reused by add() and wordFor()
+    vector<uint32_t> gramKeys;
+
+    // Per-thread buffers for search(), sized to the largest index the thread has
+    // searched. They are all zero between uses: each query clears only what it set,
+    // instead of allocating and zeroing index-sized arrays every time.
+    struct SearchBuffers {
+        vector<uint64_t> Listed;  // bitmap over documents
+        vector<uint8_t> Shared;   // trigrams shared with a fuzzy term, per vocabulary word
+    };
+
+    static SearchBuffers& buffers() {
+        static thread_local SearchBuffers local;
+        return local;
+    }
+
+    static bool ranksBefore(const Hit& a, const Hit& b) {
+        if (a.Score != b.Score) return a.Score > b.Score;
+        if (a.Length != b.Length) return a.Length < b.Length;
+        return a.Slot < b.Slot;
+    }
+
+    static vector<string_view> split(string_view value) {
+        vector<string_view> parts;
+        size_t start = 0;
+        while (start < value.size()) {
+            size_t end = value.find(' ', start);
+            if (end == string_view::npos) end = value.size();
+            parts.push_back(value.substr(start, end - start));
+            start = end + 1;
+        }
+        return parts;
+    }
+
+    // Calls fn once for each distinct word of the document.
+    template <typename Fn>
+    void forEachWord(uint32_t doc, Fn fn) const {
+        const uint32_t* ids = forward.data() + docs[doc].Forward;
+        for (uint32_t i = 0; i < docs[doc].Count; ++i) {
+            if (find(ids, ids + i, ids[i]) == ids + i) fn(ids[i]);
+        }
+    }
+
+    void compact() {
+        vector<uint32_t> renumbered(docs.size(), NoDoc);
+        pmr::vector<Doc> keptDocs(resource);
+        pmr::vector<uint32_t> keptForward(resource);
+        keptDocs.reserve(liveDocs);
+        for (uint32_t doc = 0; doc < docs.size(); ++doc) {
+            const Doc& d = docs[doc];
+            if (d.Slot == NoSlot) continue;
+            renumbered[doc] = static_cast<uint32_t>(keptDocs.size());
+            slotDocs[d.Slot] = renumbered[doc];
+            keptDocs.push_back(Doc{d.Slot, static_cast<uint32_t>(keptForward.size()), d.Count, d.Length});
+            keptForward.insert(keptForward.end(), forward.begin() + d.Forward, forward.begin() + d.Forward + d.Count);
+        }
+        for (Word& w : words) {
+            size_t kept = 0;
+            for (uint32_t doc : w.Docs) {
+                if (renumbered[doc] != NoDoc) w.Docs[kept++] = renumbered[doc];
+            }
+            w.Docs.resize(kept);
+        }
+        docs.swap(keptDocs);
+        forward.swap(keptForward);
+        retiredDocs = 0;
+    }
+
+    static size_t symbol(unsigned char c) {
+        if (c == ' ') return 0;
+        if (c >= 'a' && c <= 'z') return 1 + (c - 'a');
+        if (c >= '0' && c <= '9') return 27 + (c - '0');
+        return Symbols - 1;
+    }
+
+    // Distinct trigram keys of value, which the caller pads with spaces as needed.
+    static vector<uint32_t> trigrams(string_view value) {
+        vector<uint32_t> keys;
+        trigrams(value, keys);
+        return keys;
+    }
+
+    static void trigrams(string_view value, vector<uint32_t>& keys) {
+        keys.clear();
+        for (size_t i = 0; i + 3 <= value.size(); ++i) {
+            keys.push_back(static_cast<uint32_t>((symbol(value[i]) * Symbols + symbol(value[i + 1])) * Symbols +
+                                                 symbol(value[i + 2])));
+        }
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    }
+
+    string_view wordText(uint32_t id) const {
+        return string_view(text).substr(words[id].Offset, words[id].Length);
+    }
+
+    size_t bucketFor(string_view word) const {
+        return std::hash<string_view>()(word) & (table.size() - 1);
+    }
+
+    uint32_t findWord(string_view word) const {
+        if (table.empty()) return NoWord;
+        for (size_t pos = bucketFor(word); table[pos]; pos = (pos + 1) & (table.size() - 1)) {
+            if (wordText(table[pos] - 1) == word) return table[pos] - 1;
+        }
+        return NoWord;
+    }
+
+    uint32_t wordFor(string_view word) {
+        uint32_t id = findWord(word);
+        if (id != NoWord) return id;
+        id = static_cast<uint32_t>(words.size());
+        words.push_back(Word{static_cast<uint32_t>(text.size()), static_cast<uint32_t>(word.size()), pmr::vector<uint32_t>(resource)});
+        liveDocsOf.push_back(0);
+        text.append(word.data(), word.size());
+        if ((words.size() + 1) * 2 > table.size()) {
+            pmr::vector<uint32_t> old(max<size_t>(64, table.size() * 2), 0, table.get_allocator());
+            old.swap(table);
+            for (uint32_t entry : old) {
+                if (!entry) continue;
+                size_t pos = bucketFor(wordText(entry - 1));
+                while (table[pos]) pos = (pos + 1) & (table.size() - 1);
+                table[pos] = entry;
+            }
+        }
+        size_t pos = bucketFor(word);
+        while (table[pos]) pos = (pos + 1) & (table.size() - 1);
+        table[pos] = id + 1;
+        if (grams.empty()) grams.resize(GramCount);
+        padded.assign("  ").append(word).append(" ");
+        trigrams(padded, gramKeys);
+        for (uint32_t key : gramKeys) grams[key].push_back(id);
+        return id;
+    }
+
+    // A one-word term's list is read in order; a broader term's lists are scattered over
+    // the vocabulary (a cache miss or two each) and must be merged.
+    static size_t walkCost(const Term& term) {
+        return term.Words.size() == 1 ? term.Postings : term.Postings * 2 + term.Words.size() * 32;
+    }
+
+    static Role roleOf(NameMatch mode, size_t i, size_t count) {
+        bool last = i + 1 == count;
+        switch (mode) {
+            case NameMatch::Prefix:
+                return last ? Role::Prefix : Role::Exact;
+            case NameMatch::Substring:
+                if (count == 1) return Role::Contains;
+                return i == 0 ? Role::Suffix : last ? Role::Prefix : Role::Exact;
+            default:
+                return Role::Near;
+        }
+    }
+
+    static size_t maxEdits(string_view term) {
+        return term.size() <= 2 ? 0 : term.size() <= 5 ? 1 : 2;
+    }
+
+    // Fills term.Words with the live vocabulary words the term can stand for in its role.
+    void matchWords(Term& term) const {
+        // Fuzzy terms too short to allow an edit must match exactly (or start a word, if last).
+        Role role = term.Kind;
+        if (role == Role::Near && term.MaxEdits == 0) role = term.Last ? Role::Prefix : Role::Exact;
+        auto accept = [&term](uint32_t id) { term.Words.push_back(id); };
+        if (role == Role::Near) {
+            nearWords(term, accept);
+        } else {
+            patternWords(role, term.Text, accept);
+        }
+        if (!is_sorted(term.Words.begin(), term.Words.end())) sort(term.Words.begin(), term.Words.end());
+        term.Members.assign(words.size() / 64 + 1, 0);
+        size_t kept = 0;
+        uint32_t previous = NoWord;
+        for (uint32_t id : term.Words) {
+            if (id == previous || !liveDocsOf[id]) continue;
+            previous = id;
+            term.Words[kept++] = id;
+            term.Members[id >> 6] |= 1ull << (id & 63);
+            term.Postings += liveDocsOf[id];
+            if (term.Kind == Role::Near) term.Distances.push_back(static_cast<uint8_t>(wordDistance(term, wordText(id))));
+        }
+        term.Words.resize(kept);
+    }
+
+    template <typename Accept>
+    void patternWords(Role role, string_view t, Accept accept) const {
+        if (role == Role::Exact) {
+            uint32_t id = findWord(t);
+            if (id != NoWord) accept(id);
+            return;
+        }
+        auto matches = [role, t](string_view w) {
+            switch (role) {
+                case Role::Prefix:
+                    return w.substr(0, t.size()) == t;
+                case Role::Suffix:
+                    return w.size() >= t.size() && w.substr(w.size() - t.size()) == t;
+                default:
+                    return w.find(t) != string_view::npos;
+            }
+        };
+        string framed = role == Role::Prefix ? "  " + string(t) : role == Role::Suffix ? string(t) + " " : string(t);
+        // A three-character pattern is its own trigram, so its list needs no checking
+        // unless a byte outside the trigram alphabet made it ambiguous.
+        bool exact = framed.size() == 3 && all_of(framed.begin(), framed.end(), [](char c) { return symbol(c) != Symbols - 1; });
+        auto acceptMatches = [&](const pmr::vector<uint32_t>& list) {
+            for (uint32_t id : list) {
+                if (exact || matches(wordText(id))) accept(id);
+            }
+        };
+        if (grams.empty()) return;
+        if (framed.size() == 2) {
+            // Two characters: the word has one of the trigrams made by adding a neighbour.
+            for (size_t other = 0; other < Symbols; ++other) {
+                size_t a = symbol(framed[0]), b = symbol(framed[1]);
+                acceptMatches(grams[role == Role::Suffix ? (other * Symbols + a) * Symbols + b : (a * Symbols + b) * Symbols + other]);
+            }
+            return;
+        }
+        vector<uint32_t> keys = trigrams(framed);
+        if (keys.empty()) {
+            for (uint32_t id = 0; id < words.size(); ++id) {
+                if (matches(wordText(id))) accept(id);
+            }
+            return;
+        }
+        // Every matching word carries every trigram of the pattern; walk the shortest list.
+        const pmr::vector<uint32_t>* shortest = &grams[keys[0]];
+        for (uint32_t key : keys) {
+            if (grams[key].size() < shortest->size()) shortest = &grams[key];
+        }
+        acceptMatches(*shortest);
+    }
+
+    // Vocabulary words close enough to a fuzzy term (see wordDistance). Words one edit
+    // away are found exactly, by looking up every deletion, swap, substitution and
+    // insertion of the term; trigrams are too coarse for that on short words, where a
+    // single edit can touch every trigram. Two-edit matches are drawn from the words
+    // sharing the most of the term's rarer trigrams, at most about FuzzyBudget of them,
+    // so a common trigram cannot turn a lookup into a scan of the whole vocabulary.
+    template <typename Accept>
+    void nearWords(const Term& term, Accept accept) const {
+        static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+        string_view t = term.Text;
+        patternWords(term.Last ? Role::Prefix : Role::Exact, t, accept);
+        string variant;
+        auto tryVariant = [&]() {
+            uint32_t id = findWord(variant);
+            if (id != NoWord) accept(id);
+        };
+        for (size_t i = 0; i <= t.size(); ++i) {
+            for (const char* c = alphabet; *c; ++c) {
+                variant.assign(t.data(), i).append(1, *c).append(t.substr(i));
+                tryVariant();
+                if (i == t.size() || *c == t[i]) continue;
+                variant.assign(t.data(), t.size())[i] = *c;
+                tryVariant();
+            }
+            if (i == t.size()) break;
+            variant.assign(t.data(), i).append(t.substr(i + 1));
+            tryVariant();
+            if (i + 1 < t.size() && t[i] != t[i + 1]) {
+                variant.assign(t.data(), t.size());
+                std::swap(variant[i], variant[i + 1]);
+                tryVariant();
+            }
+        }
+        if (term.MaxEdits < 2 || grams.empty()) return;
+
+        // The rarest trigrams are counted first, and the common ones are skipped once
+        // GramBudget list entries have been read.
+        vector<uint32_t> keys = trigrams("  " + string(t) + " ");
+        sort(keys.begin(), keys.end(), [this](uint32_t a, uint32_t b) { return grams[a].size() < grams[b].size(); });
+        vector<uint8_t>& shared = buffers().Shared;
+        if (shared.size() < words.size()) shared.resize(words.size(), 0);
+        vector<uint32_t> touched;
+        size_t read = 0;
+        for (uint32_t key : keys) {
+            if (read > 0 && read + grams[key].size() > GramBudget) break;
+            read += grams[key].size();
+            for (uint32_t id : grams[key]) {
+                if (shared[id] == 0) touched.push_back(id);
+                if (shared[id] < UINT8_MAX) shared[id]++;
+            }
+        }
+        array<size_t, UINT8_MAX + 1> histogram{};
+        for (uint32_t id : touched) histogram[shared[id]]++;
+        size_t cutoff = UINT8_MAX;
+        size_t kept = histogram[cutoff];
+        while (cutoff > 1 && (kept == 0 || kept + histogram[cutoff - 1] <= FuzzyBudget)) kept += histogram[--cutoff];
+        for (uint32_t id : touched) {
+            if (shared[id] >= cutoff && wordDistance(term, wordText(id)) <= term.MaxEdits) accept(id);
+        }
+        for (uint32_t id : touched) shared[id] = 0;
+    }
+
+    // How far a name word is from a fuzzy term: its edit distance, except that the last
+    // term also matches the start of a word, so "bolt m" finds "bolt m8".
+    static size_t wordDistance(const Term& term, string_view word) {
+        if (term.Last && word.substr(0, term.Text.size()) == term.Text) return 0;
+        return editDistance(term.Text, word, term.MaxEdits);
+    }
+
+    // Optimal string alignment distance (edits plus swaps of adjacent characters), or
+    // limit + 1 once it must exceed limit.
+    static size_t editDistance(string_view a, string_view b, size_t limit) {
+        a = a.substr(0, MaxWord);
+        b = b.substr(0, MaxWord);
+        if (a.size() > b.size() + limit || b.size() > a.size() + limit) return limit + 1;
+        array<array<size_t, MaxWord + 1>, 3> rows;
+        size_t* before = rows[0].data();
+        size_t* previous = rows[1].data();
+        size_t* current = rows[2].data();
+        for (size_t j = 0; j <= b.size(); ++j) previous[j] = j;
+        for (size_t i = 1; i <= a.size(); ++i) {
+            current[0] = i;
+            size_t rowMin = i;
+            for (size_t j = 1; j <= b.size(); ++j) {
+                size_t d = min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + (a[i - 1] != b[j - 1])});
+                if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) d = min(d, before[j - 2] + 1);
+                current[j] = d;
+                rowMin = min(rowMin, d);
+            }
+            if (rowMin > limit) return limit + 1;
+            size_t* recycled = before;
+            before = previous;
+            previous = current;
+            current = recycled;
+        }
+        return min(previous[b.size()], limit + 1);
+    }
+
+    // Best alignment of the query words on consecutive name words: 3 for the whole name,
+    // 2 at its start, 1 at a word start and 0 inside a word, plus a half when the match
+    // ends on a word boundary; -1 when the name does not match.
+    double textScore(const Doc& d, const vector<Term>& plan, NameMatch mode) const {
+        const uint32_t* ids = forward.data() + d.Forward;
+        size_t m = plan.size();
+        if (d.Count < m) return -1;
+        const Term& head = plan.front();
+        const Term& tail = plan.back();
+        double best = -1;
+        for (size_t p = 0; p <= (mode == NameMatch::Prefix ? 0 : d.Count - m); ++p) {
+            size_t i = 0;
+            while (i < m && plan[i].has(ids[p + i])) ++i;
+            if (i < m) continue;
+            string_view first = wordText(ids[p]);
+            string_view last = wordText(ids[p + m - 1]);
+            bool atWordStart = head.Kind == Role::Suffix   ? first.size() == head.Text.size()
+                               : head.Kind == Role::Contains ? first.substr(0, head.Text.size()) == head.Text
+                                                             : true;
+            bool atWordEnd = tail.Kind == Role::Prefix ? last.size() == tail.Text.size()
+                             : tail.Kind == Role::Contains
+                                 ? last.size() == tail.Text.size() ||
+                                       (!atWordStart && last.substr(last.size() - tail.Text.size()) == tail.Text)
+                                 : true;
+            double score = !atWordStart ? 0 : p > 0 ? 1 : atWordEnd && m == d.Count ? 3 : 2;
+            if (atWordEnd) score += 0.5;
+            best = max(best, score);
+        }
+        return best;
+    }
+
+    // Mean closeness of each query word to its nearest name word; -1 if any is too far.
+    double fuzzyScore(const Doc& d, const vector<Term>& plan) const {
+        const uint32_t* ids = forward.data() + d.Forward;
+        double total = 0;
+        for (const Term& term : plan) {
+            size_t best = term.MaxEdits + 1;
+            for (uint32_t i = 0; i < d.Count && best > 0; ++i) {
+                if (!term.has(ids[i])) continue;
+                size_t at = static_cast<size_t>(lower_bound(term.Words.begin(), term.Words.end(), ids[i]) - term.Words.begin());
+                best = min<size_t>(best, term.Distances.empty() ? 0 : term.Distances[at]);
+            }
+            if (best > term.MaxEdits) return -1;
+            total += 1.0 - static_cast<double>(best) / static_cast<double>(term.Text.size() + 1);
+        }
+        return total / static_cast<double>(plan.size());
+    }
+};
+
+// One equality condition of an attribute query.
+template <typename T>
+struct AttributeFilter {
+    const AttributeIndex* Index;
+    InternedString T::*Field;
+    uint32_t Code;
+};
+
+// Calls fn for every record matching all filters. Walks the shortest posting list and
+// checks the other attributes on the record itself, so the cost follows the most
+// selective filter rather than the table size.
+template <typename T, typename Fn>
+size_t forEachMatch(const SlotMap<T>& records, const vector<AttributeFilter<T>>& filters, Fn fn) {
+    if (filters.empty()) {
+        for (const auto& record : records) fn(record);
+        return records.size();
+    }
+    const AttributeFilter<T>* driver = &filters[0];
+    for (const auto& filter : filters) {
+        if (filter.Index->postings(filter.Code).size() < driver->Index->postings(driver->Code).size()) driver = &filter;
+    }
+    size_t matched = 0;
+    for (const auto& posting : driver->Index->postings(driver->Code)) {
+        const T* record = records.get(posting.Handle);
+        bool match = true;
+        for (const auto& filter : filters) {
+            if (&filter != driver && (record->*filter.Field).code() != filter.Code) {
+                match = false;
+                break;
+            }
+        }
+        if (match) {
+            fn(*record);
+            matched++;
+        }
+    }
+    return matched;
+}
+
+// Adds an equality filter when a value is given. Returns false if the value was never
+// stored, in which case nothing can match.
+template <typename T>
+bool appendFilter(vector<AttributeFilter<T>>& filters, const AttributeIndex& index, InternedString T::*field,
+                  const optional<string>& value) {
+    if (!value) return true;
+    uint32_t code;
+    if (!StringDictionary::shared().find(*value, code)) return false;
+    filters.push_back(AttributeFilter<T>{&index, field, code});
+    return true;
+}
+
+// Prompts for one attribute of a query; a blank line leaves it unset.
+optional<string> readFilter(const char* label) {
+    string value;
+    cout << "Enter " << label << " (blank for any): ";
+    getline(cin, value);
+    if (value.empty()) return nullopt;
+    return value;
+}
+
+// --- TimestampFormatter Class ---
+// Formats time_t values as local "YYYY-MM-DD HH:MM:SS" straight into a caller buffer,
+// and parses that form (or a bare date, or epoch seconds) back.
+// Each thread keeps a small direct-mapped cache of local days; a timestamp inside a
+// cached day only needs its clock digits. Days with a UTC offset change (DST) are
+// never cached and go through localtime for every call.
+class TimestampFormatter {
+public:
+    static constexpr size_t Length = 19;
+
+    static size_t format(time_t value, char* out) {
+        static thread_local array<Day, DayCacheSize> days{};
+        Day& day = days[static_cast<size_t>(floorDiv(value, 86400)) % DayCacheSize];
+        if (!day.Valid || value < day.Start || value >= day.Start + 86400) {
+            tm t;
+            if (!toLocal(value, t)) {
+                memcpy(out, "0000-00-00 00:00:00", Length);
+                return Length;
+            }
+            if (!cacheDay(value, t, day)) {
+                writeDate(t, out);
+                writeClock(t.tm_hour * 3600 + t.tm_min * 60 + t.tm_sec, out + 11);
+                return Length;
+            }
+        }
+        memcpy(out, day.Date, 11);
+        writeClock(static_cast<int>(value - day.Start), out + 11);
+        return Length;
+    }
+
+    static string format(time_t value) {
+        char text[Length];
+        return string(text, format(value, text));
+    }
+
+    // Accepts epoch seconds, "YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS" (local time).
+    // Inputs repeat a handful of dates, so converted dates are cached per thread
+    // instead of calling mktime every time.
+    static bool parse(string_view v, time_t& out) {
+        long long epoch = 0;
+        auto parsed = from_chars(v.data(), v.data() + v.size(), epoch);
+        if (!v.empty() && parsed.ec == errc() && parsed.ptr == v.data() + v.size()) {
+            out = static_cast<time_t>(epoch);
+            return true;
+        }
+        if (v.size() != 10 && v.size() != 19) return false;
+        thread_local unordered_map<string, time_t> cache;
+        string key(v);
+        auto hit = cache.find(key);
+        if (hit != cache.end()) {
+            out = hit->second;
+            return true;
+        }
+        auto digits = [&v](size_t pos, size_t count, int& value) {
+            auto r = from_chars(v.data() + pos, v.data() + pos + count, value);
+            return r.ec == errc() && r.ptr == v.data() + pos + count;
+        };
+        tm t{};
+        bool ok = digits(0, 4, t.tm_year) && v[4] == '-' && digits(5, 2, t.tm_mon) && v[7] == '-' && digits(8, 2, t.tm_mday);
+        if (ok && v.size() == 19) {
+            ok = (v[10] == ' ' || v[10] == 'T') && digits(11, 2, t.tm_hour) && v[13] == ':' && digits(14, 2, t.tm_min) &&
+                 v[16] == ':' && digits(17, 2, t.tm_sec);
+        }
+        if (!ok || t.tm_mon < 1 || t.tm_mon > 12 || t.tm_mday < 1 || t.tm_mday > 31) return false;
+        t.tm_year -= 1900;
+        t.tm_mon -= 1;
+        t.tm_isdst = -1;
+        out = mktime(&t);
+        if (out == static_cast<time_t>(-1)) return false;
+        if (cache.size() > 4096) cache.clear();
+        cache.emplace(move(key), out);
+        return true;
+    }
+
+private:
+    static constexpr size_t DayCacheSize = 64;
+
+    struct Day {
+        time_t Start = 0;
+        bool Valid = false;
+        char Date[11];
+    };
+
+    static time_t floorDiv(time_t value, time_t divisor) {
+        time_t q = value / divisor;
+        return value % divisor < 0 ? q - 1 : q;
+    }
+
+    static bool toLocal(time_t value, tm& t) {
+#ifdef _MSC_VER
+        return localtime_s(&t, &value) == 0;
+#else
+        return localtime_r(&value, &t) != nullptr;
+#endif
+    }
+
+    // Caches the day containing `value` if its last second is 86399 s after midnight.
+    static bool cacheDay(time_t value, const tm& t, Day& day) {
+        time_t start = value - (t.tm_hour * 3600 + t.tm_min * 60 + t.tm_sec);
+        tm last;
+        if (!toLocal(start + 86399, last) || last.tm_mday != t.tm_mday || last.tm_hour != 23 ||
+            last.tm_min != 59 || last.tm_sec != 59) {
+            day.Valid = false;
+            return false;
+        }
+        day.Start = start;
+        day.Valid = true;
+        writeDate(t, day.Date);
+        return true;
+    }
+
+    static void writeTwo(int value, char* out) {
+        out[0] = static_cast<char>('0' + value / 10);
+        out[1] = static_cast<char>('0' + value % 10);
+    }
+
+    static void writeDate(const tm& t, char* out) {
+        int year = t.tm_year + 1900;
+        if (year < 0 || year > 9999) year = 0;
+        writeTwo(year / 100, out);
+        writeTwo(year % 100, out + 2);
+        out[4] = '-';
+        writeTwo(t.tm_mon + 1, out + 5);
+        out[7] = '-';
+        writeTwo(t.tm_mday, out + 8);
+        out[10] = ' ';
+    }
+
+    static void writeClock(int seconds, char* out) {
+        writeTwo(seconds / 3600, out);
+        out[2] = ':';
+        writeTwo(seconds / 60 % 60, out + 3);
+        out[5] = ':';
+        writeTwo(seconds % 60, out + 6);
+    }
+};
+
+// --- RecordWriter Class ---
+enum class RenderFormat { Human, JsonLines, Tsv };
+
+// Formats records into a reusable buffer and hands it to the stream in large blocks,
+// so listings cost one write per ~64 KiB instead of a flush per field. Entities
+// describe themselves through beginRecord / field / endRecord and the writer lays
+// them out as the human listing, JSON Lines or TSV (with a header row per record kind).
+class RecordWriter {
+private:
+    static constexpr size_t FlushThreshold = 64 * 1024;
+
+    ostream& out;
+    RenderFormat format;
+    string buffer;
+    string header;
+    const char* headerKind = nullptr;
+    size_t recordStart = 0;
+    bool firstField = true;
+    bool wantHeader = false;
+
+    void appendInt(long long value) {
+        char digits[24];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, static_cast<size_t>(result.ptr - digits));
+    }
+
+    void appendTime(time_t value) {
+        char text[TimestampFormatter::Length];
+        buffer.append(text, TimestampFormatter::format(value, text));
+    }
+
+    void appendJsonString(string_view value) {
+        buffer.push_back('"');
+        for (char c : value) {
+            switch (c) {
+                case '"': buffer.append("\\\""); break;
+                case '\\': buffer.append("\\\\"); break;
+                case '\n': buffer.append("\\n"); break;
+                case '\r': buffer.append("\\r"); break;
+                case '\t': buffer.append("\\t"); break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        static const char hex[] = "0123456789abcdef";
+                        buffer.append("\\u00");
+                        buffer.push_back(hex[(c >> 4) & 0xF]);
+                        buffer.push_back(hex[c & 0xF]);
+                    } else {
+                        buffer.push_back(c);
+                    }
+            }
+        }
+        buffer.push_back('"');
+    }
+
+    void appendTsvText(string_view value) {
+        for (char c : value) {
+            switch (c) {
+                case '\t': buffer.append("\\t"); break;
+                case '\n': buffer.append("\\n"); break;
+                case '\r': buffer.append("\\r"); break;
+                case '\\': buffer.append("\\\\"); break;
+                default: buffer.push_back(c);
+            }
+        }
+    }
+
+    // Writes the separator and label/key that precede a value.
+    void beginField(const char* label, const char* key) {
+        switch (format) {
+            case RenderFormat::Human:
+                buffer.append(label);
+                buffer.append(": ");
+                break;
+            case RenderFormat::JsonLines:
+                if (!firstField) buffer.push_back(',');
+                buffer.push_back('"');
+                buffer.append(key);
+                buffer.append("\":");
+                break;
+            case RenderFormat::Tsv:
+                if (!firstField) buffer.push_back('\t');
+                if (wantHeader) {
+                    if (!firstField) header.push_back('\t');
+                    header.append(key);
+                }
+                break;
+        }
+        firstField = false;
+    }
+
+    void endField() {
+        if (format == RenderFormat::Human) buffer.push_back('\n');
+    }
+
+public:
+    explicit RecordWriter(ostream& stream, RenderFormat fmt = RenderFormat::Human) : out(stream), format(fmt) {
+        buffer.reserve(FlushThreshold + 4096);
+    }
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    ~RecordWriter() {
+        flush();
+    }
+
+    static bool parseFormat(const string& name, RenderFormat& fmt) {
+        if (name == "human") {
+            fmt = RenderFormat::Human;
+        } else if (name == "jsonl") {
+            fmt = RenderFormat::JsonLines;
+        } else if (name == "tsv") {
+            fmt = RenderFormat::Tsv;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    void beginRecord(const char* kind) {
+        recordStart = buffer.size();
+        firstField = true;
+        wantHeader = format == RenderFormat::Tsv && kind != headerKind;
+        if (wantHeader) {
+            headerKind = kind;
+            header.clear();
+        }
+        if (format == RenderFormat::JsonLines) buffer.push_back('{');
+    }
+
+    void field(const char* label, const char* key, long long value) {
+        beginField(label, key);
+        appendInt(value);
+        endField();
+    }
+
+    void field(const char* label, const char* key, string_view value) {
+        beginField(label, key);
+        if (format == RenderFormat::JsonLines) {
+            appendJsonString(value);
+        } else if (format == RenderFormat::Tsv) {
+            appendTsvText(value);
+        } else {
+            buffer.append(value.data(), value.size());
+        }
+        endField();
+    }
+
+    void field(const char* label, const char* key, const string& value) {
+        field(label, key, string_view(value));
+    }
+
+    // Human listings show local time; machine formats carry epoch seconds.
+    void timeField(const char* label, const char* key, time_t value) {
+        beginField(label, key);
+        if (format == RenderFormat::Human) {
+            appendTime(value);
+        } else {
+            appendInt(static_cast<long long>(value));
+        }
+        endField();
+    }
+
+    void endRecord() {
+        switch (format) {
+            case RenderFormat::Human:
+                buffer.append("-------------------------\n");
+                break;
+            case RenderFormat::JsonLines:
+                buffer.append("}\n");
+                break;
+            case RenderFormat::Tsv:
+                buffer.push_back('\n');
+                if (wantHeader) {
+                    header.push_back('\n');
+                    buffer.insert(recordStart, header);
+                    wantHeader = false;
+                }
+                break;
+        }
+        if (buffer.size() >= FlushThreshold) flush();
+    }
+
+    void text(const string& line) {
+        buffer.append(line);
+        buffer.push_back('\n');
+    }
+
+    void flush() {
+        if (buffer.empty()) return;
+        out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        buffer.clear();
+        out.flush();
+    }
+};
+
+// --- Metrics Class ---
+// Repository operations counted and timed by OperationTimer.
+enum class MetricOp : uint8_t {
+    AddInventory,
+    SearchInventory,
+    EditInventory,
+    DeleteInventory,
+    FindInventory,
+    ScheduleMaintenance,
+    ViewSchedule,
+    UpdateSchedule,
+    RemoveMaintenance,
+    DueBetween,
+    OverdueSchedules,
+    NextDue,
+    CompleteNextDue,
+    GenerateReport,
+    DownloadReport,
+    ReceiveShipment,
+    TrackShipment,
+    DispatchShipment,
+    RemoveShipment,
+    ExpireShipments,
+    FindShipments,
+    JoinItems,
+    DeliveriesBetween,
+    AdvanceClock,
+    OverdueShipments,
+    AllocateSpace,
+    SearchSpace,
+    UpdateSpace,
+    FreeSpace,
+    ReserveCapacity,
+    ReleaseCapacity,
+    BestFit,
+    ApplyBatch,
+    SearchName,
+    Count
+};
+
+// Per-thread operation counters and log2-bucketed latency histograms, merged on read.
+// Each thread writes only its own block, with plain relaxed stores, so recording
+// never contends. Every call is counted; one call in SampleEvery of each operation
+// is timed, which keeps clock reads off most calls.
+class Metrics {
+public:
+    static constexpr size_t OpCount = static_cast<size_t>(MetricOp::Count);
+    static constexpr size_t Buckets = 40;  // bucket b: latencies below 2^b ns
+    static constexpr uint64_t SampleEvery = 64;
+
+    struct ThreadBlock {
+        array<atomic<uint64_t>, OpCount> Calls{};
+        array<atomic<uint64_t>, OpCount> Samples{};
+        array<atomic<uint64_t>, OpCount> SampledNanos{};
+        array<array<atomic<uint64_t>, Buckets>, OpCount> Histogram{};
+    };
+
+    struct Totals {
+        array<uint64_t, OpCount> Calls{};
+        array<uint64_t, OpCount> Samples{};
+        array<uint64_t, OpCount> SampledNanos{};
+        array<array<uint64_t, Buckets>, OpCount> Histogram{};
+
+        // Upper bound, in ns, of the bucket holding quantile q of the sampled latencies.
+        uint64_t quantile(MetricOp op, double q) const {
+            size_t i = static_cast<size_t>(op);
+            uint64_t rank = static_cast<uint64_t>(q * Samples[i]);
+            uint64_t seen = 0;
+            for (size_t b = 0; b < Buckets; ++b) {
+                seen += Histogram[i][b];
+                if (seen > rank) return 1ull << b;
+            }
+            return 1ull << (Buckets - 1);
+        }
+    };
+
+private:
+    mutex mtx;
+    vector<unique_ptr<ThreadBlock>> blocks;
+
+    static thread_local ThreadBlock* current;
+    static thread_local bool muted;
+
+    static void bump(atomic<uint64_t>& counter, uint64_t by) {
+        counter.store(counter.load(memory_order_relaxed) + by, memory_order_relaxed);
+    }
+
+    ThreadBlock* registerThread() {
+        lock_guard<mutex> lock(mtx);
+        blocks.push_back(make_unique<ThreadBlock>());
+        return blocks.back().get();
+    }
+
+public:
+    static Metrics& shared() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    // Silences OperationTimer on this thread while it lives. Journal replay, at startup
+    // and in the compactor, re-applies records through the public mutators, and those
+    // calls are not live traffic.
+    class Mute {
+    private:
+        bool previous;
+
+    public:
+        Mute() : previous(muted) {
+            muted = true;
+        }
+
+        ~Mute() {
+            muted = previous;
+        }
+
+        Mute(const Mute&) = delete;
+        Mute& operator=(const Mute&) = delete;
+    };
+
+    static bool isMuted() {
+        return muted;
+    }
+
+    // The calling thread's block; blocks outlive their threads so totals never drop.
+    static ThreadBlock& local() {
+        if (!current) current = shared().registerThread();
+        return *current;
+    }
+
+    static const char* name(MetricOp op) {
+        static const char* names[OpCount] = {
+            "add_inventory",        "search_inventory",   "edit_inventory",    "delete_inventory",  "find_inventory",
+            "schedule_maintenance", "view_schedule",      "update_schedule",   "remove_maintenance", "due_between",
+            "overdue_schedules",    "next_due",           "complete_next_due", "generate_report",   "download_report",
+            "receive_shipment",     "track_shipment",     "dispatch_shipment", "remove_shipment",   "expire_shipments",
+            "find_shipments",       "join_items",         "deliveries_between", "advance_clock",    "overdue_shipments",
+            "allocate_space",       "search_space",       "update_space",      "free_space",        "reserve_capacity",
+            "release_capacity",     "best_fit",           "apply_batch",       "search_name"};
+        return names[static_cast<size_t>(op)];
+    }
+
+    // Returns true if this call should be timed.
+    static bool count(ThreadBlock& block, MetricOp op) {
+        atomic<uint64_t>& calls = block.Calls[static_cast<size_t>(op)];
+        uint64_t n = calls.load(memory_order_relaxed);
+        calls.store(n + 1, memory_order_relaxed);
+        return (n & (SampleEvery - 1)) == 0;
+    }
+
+    static void observe(ThreadBlock& block, MetricOp op, uint64_t nanos) {
+        size_t i = static_cast<size_t>(op);
+        size_t bucket = 0;
+        while (bucket + 1 < Buckets && (nanos >> bucket) != 0) bucket++;
+        bump(block.Samples[i], 1);
+        bump(block.SampledNanos[i], nanos);
+        bump(block.Histogram[i][bucket], 1);
+    }
+
+    Totals totals() {
+        Totals t;
+        lock_guard<mutex> lock(mtx);
+        for (const auto& block : blocks) {
+            for (size_t i = 0; i < OpCount; ++i) {
+                t.Calls[i] += block->Calls[i].load(memory_order_relaxed);
+                t.Samples[i] += block->Samples[i].load(memory_order_relaxed);
+                t.SampledNanos[i] += block->SampledNanos[i].load(memory_order_relaxed);
+                for (size_t b = 0; b < Buckets; ++b) t.Histogram[i][b] += block->Histogram[i][b].load(memory_order_relaxed);
+            }
+        }
+        return t;
+    }
+};
+
+thread_local Metrics::ThreadBlock* Metrics::current = nullptr;
+thread_local bool Metrics::muted = false;
+
+// Counts one repository operation and, when sampled, records how long the scope took.
+class OperationTimer {
+private:
+    Metrics::ThreadBlock* block;
+    MetricOp op;
+    bool sampled;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit OperationTimer(MetricOp o)
+        : block(Metrics::isMuted() ? nullptr : &Metrics::local()), op(o), sampled(block && Metrics::count(*block, o)) {
+        if (sampled) start = chrono::steady_clock::now();
+    }
+
+    ~OperationTimer() {
+        if (!sampled) return;
+        auto nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        Metrics::observe(*block, op, static_cast<uint64_t>(max<long long>(nanos, 0)));
+    }
+
+    OperationTimer(const OperationTimer&) = delete;
+    OperationTimer& operator=(const OperationTimer&) = delete;
+};
+
+// --- ReportAggregates Class ---
+// Running totals behind the built-in reports. Repositories push each record's
+// contribution in (+1) and out (-1) on every change, so reading a report costs
+// O(groups) no matter how many records there are. Groups are keyed by dictionary code,
+// and each set keeps a list of the codes that currently have records.
+class ReportAggregates {
+public:
+    struct Group {
+        long long Records = 0;
+        long long Units = 0;
+        long long Capacity = 0;
+        uint32_t Live = 0; // position in GroupSet::Live while Records is non-zero
+    };
+
+    explicit ReportAggregates(pmr::memory_resource* resource = pmr::get_default_resource())
+        : stockByCategory(resource), shipmentsByStatus(resource), spaceByZone(resource) {}
+
+    void stock(uint32_t category, int quantity, int sign) {
+        Group& g = count(stockByCategory, category, sign);
+        g.Units += static_cast<long long>(sign) * quantity;
+    }
+
+    void shipment(uint32_t status, int sign) {
+        count(shipmentsByStatus, status, sign);
+    }
+
+    void space(uint32_t zone, int total, int used, int sign) {
+        Group& g = count(spaceByZone, zone, sign);
+        g.Units += static_cast<long long>(sign) * used;
+        g.Capacity += static_cast<long long>(sign) * total;
+    }
+
+    void maintenance(bool completed, int sign) {
+        (completed ? completedSchedules : openSchedules) += sign;
+    }
+
+    // Names of the report types computed from the aggregates.
+    static const vector<string>& builtInTypes() {
+        static const vector<string> types = {"Stock by Category", "Shipments by Status", "Space Utilisation by Zone",
+                                             "Maintenance Backlog"};
+        return types;
+    }
+
+    // Case-insensitive lookup; returns -1 for a free-text report type.
+    static int builtInIndex(const string& type) {
+        const auto& types = builtInTypes();
+        for (size_t i = 0; i < types.size(); ++i) {
+            if (types[i].size() == type.size() &&
+                equal(types[i].begin(), types[i].end(), type.begin(),
+                      [](char a, char b) { return tolower(static_cast<unsigned char>(a)) == tolower(static_cast<unsigned char>(b)); })) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    size_t bytesUsed() const {
+        size_t bytes = 0;
+        for (const GroupSet* set : {&stockByCategory, &shipmentsByStatus, &spaceByZone}) {
+            bytes += set->ByCode.capacity() * sizeof(Group) + set->Live.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+    string details(int type) const {
+        string text;
+        switch (type) {
+            case 0:
+                appendGroups(text, stockByCategory, [](string& out, const Group& g) {
+                    out += to_string(g.Units) + " units in " + to_string(g.Records) + " item(s)";
+                });
+                break;
+            case 1:
+                appendGroups(text, shipmentsByStatus, [](string& out, const Group& g) {
+                    out += to_string(g.Records) + " shipment(s)";
+                });
+                break;
+            case 2:
+                appendGroups(text, spaceByZone, [](string& out, const Group& g) {
+                    out += to_string(g.Units) + "/" + to_string(g.Capacity) + " used";
+                    if (g.Capacity > 0) out += " (" + to_string(g.Units * 100 / g.Capacity) + "%)";
+                    out += " in " + to_string(g.Records) + " space(s)";
+                });
+                break;
+            case 3:
+                text = to_string(openSchedules) + " open, " + to_string(completedSchedules) + " completed";
+                break;
+        }
+        return text.empty() ? "No data" : text;
+    }
+
+private:
+    struct GroupSet {
+        pmr::vector<Group> ByCode;
+        pmr::vector<uint32_t> Live;
+
+        explicit GroupSet(pmr::memory_resource* resource) : ByCode(resource), Live(resource) {}
+    };
+
+    GroupSet stockByCategory;
+    GroupSet shipmentsByStatus;
+    GroupSet spaceByZone;
+    long long openSchedules = 0;
+    long long completedSchedules = 0;
+
+    // Adds sign to the group's record count, entering or leaving the live list when
+    // the count crosses zero.
+    static Group& count(GroupSet& set, uint32_t code, int sign) {
+        if (code >= set.ByCode.size()) set.ByCode.resize(code + 1);
+        Group& g = set.ByCode[code];
+        if (g.Records == 0) {
+            g.Live = static_cast<uint32_t>(set.Live.size());
+            set.Live.push_back(code);
+        }
+        g.Records += sign;
+        if (g.Records == 0) {
+            uint32_t moved = set.Live.back();
+            set.Live[g.Live] = moved;
+            set.ByCode[moved].Live = g.Live;
+            set.Live.pop_back();
+        }
+        return g;
+    }
+
+    // "name: figures; name: figures" for every non-empty group, sorted by name.
+    template <typename Describe>
+    static void appendGroups(string& text, const GroupSet& set, Describe describe) {
+        vector<uint32_t> codes(set.Live.begin(), set.Live.end());
+        const StringDictionary& dictionary = StringDictionary::shared();
+        sort(codes.begin(), codes.end(), [&dictionary](uint32_t a, uint32_t b) { return dictionary.text(a) < dictionary.text(b); });
+        for (uint32_t code : codes) {
+            if (!text.empty()) text += "; ";
+            text += code ? dictionary.text(code) : "(none)";
+            text += ": ";
+            describe(text, set.ByCode[code]);
+        }
+    }
+};
+
+// --- Inventory Class ---
+// Fields scans read come first; with the name out of line a record is 32 bytes and
+// never straddles a cache line.
+class alignas(32) Inventory {
+public:
+    int ItemId;
+    int Quantity;
+    InternedString Category;
+    InternedString Location;
+    time_t LastUpdated;
+    HeapString ItemName;
+
+    Inventory(int id = 0, HeapString name = {}, InternedString cat = {}, int qty = 0, InternedString loc = {})
+        : ItemId(id), Quantity(qty), Category(cat), Location(loc), LastUpdated(time(nullptr)), ItemName(move(name)) {}
+
+    void render(RecordWriter& out) const {
+        out.beginRecord("inventory");
+        out.field("Item ID", "ItemId", ItemId);
+        out.field("Name", "ItemName", ItemName);
+        out.field("Category", "Category", Category);
+        out.field("Quantity", "Quantity", Quantity);
+        out.field("Location", "Location", Location);
+        out.timeField("Last Updated", "LastUpdated", LastUpdated);
+        out.endRecord();
+    }
+
+    void display() const {
+        RecordWriter out(cout);
+        render(out);
+    }
+
+    void writeTo(ByteWriter& out) const {
+        out.putI32(ItemId);
+        out.putString(ItemName);
+        out.putString(Category);
+        out.putI32(Quantity);
+        out.putString(Location);
+        out.putI64(LastUpdated);
+    }
+
+    static Inventory readFrom(ByteReader& in) {
+        Inventory item;
+        item.ItemId = in.getI32();
+        item.ItemName = in.getString();
+        item.Category = in.getString();
+        item.Quantity = in.getI32();
+        item.Location = in.getString();
+        item.LastUpdated = static_cast<time_t>(in.getI64());
+        return item;
+    }
+};
+
+// --- InventoryColumns Class ---
+// Structure-of-arrays copy of the hot inventory fields, kept row-for-row in the same
+// order as the SlotMap's dense array (including its swap-remove on erase). Scans over
+// quantities and timestamps touch only these columns, never the item names.
+class InventoryColumns {
+public:
+    pmr::vector<int32_t> ItemIds;
+    pmr::vector<int32_t> Quantities;
+    pmr::vector<int64_t> LastUpdated;
+    pmr::vector<uint32_t> Categories;
+    pmr::vector<uint32_t> Locations;
+
+    explicit InventoryColumns(pmr::memory_resource* resource = pmr::get_default_resource())
+        : ItemIds(resource), Quantities(resource), LastUpdated(resource), Categories(resource), Locations(resource) {}
+
+    void append(const Inventory& item) {
+        ItemIds.push_back(item.ItemId);
+        Quantities.push_back(item.Quantity);
+        LastUpdated.push_back(static_cast<int64_t>(item.LastUpdated));
+        Categories.push_back(item.Category.code());
+        Locations.push_back(item.Location.code());
+    }
+
+    void assign(size_t row, const Inventory& item) {
+        ItemIds[row] = item.ItemId;
+        Quantities[row] = item.Quantity;
+        LastUpdated[row] = static_cast<int64_t>(item.LastUpdated);
+        Categories[row] = item.Category.code();
+        Locations[row] = item.Location.code();
+    }
+
+    void removeRow(size_t row) {
+        size_t last = ItemIds.size() - 1;
+        if (row != last) {
+            ItemIds[row] = ItemIds[last];
+            Quantities[row] = Quantities[last];
+            LastUpdated[row] = LastUpdated[last];
+            Categories[row] = Categories[last];
+            Locations[row] = Locations[last];
+        }
+        ItemIds.pop_back();
+        Quantities.pop_back();
+        LastUpdated.pop_back();
+        Categories.pop_back();
+        Locations.pop_back();
+    }
+
+    void reserve(size_t n) {
+        ItemIds.reserve(n);
+        Quantities.reserve(n);
+        LastUpdated.reserve(n);
+        Categories.reserve(n);
+        Locations.reserve(n);
+    }
+
+    void clear() {
+        ItemIds.clear();
+        Quantities.clear();
+        LastUpdated.clear();
+        Categories.clear();
+        Locations.clear();
+    }
+
+    size_t bytesUsed() const {
+        return (ItemIds.capacity() + Quantities.capacity() + Categories.capacity() + Locations.capacity()) * sizeof(uint32_t) +
+               LastUpdated.capacity() * sizeof(int64_t);
+    }
+
+    size_t size() const {
+        return ItemIds.size();
+    }
+
+    long long totalQuantity() const {
+        const int32_t* q = Quantities.data();
+        size_t n = Quantities.size();
+        size_t i = 0;
+        long long total = 0;
+#ifdef __SSE2__
+        // Sign-extend four quantities to two pairs of 64-bit lanes per step.
+        __m128i sum = _mm_setzero_si128();
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i));
+            __m128i sign = _mm_srai_epi32(v, 31);
+            sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(v, sign));
+            sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(v, sign));
+        }
+        alignas(16) long long lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+        total = lanes[0] + lanes[1];
+#endif
+        for (; i < n; ++i) total += q[i];
+        return total;
+    }
+
+    // Adds each row's quantity to totals[group(code)] for the given code column.
+    template <typename Group>
+    void quantityBy(const pmr::vector<uint32_t>& codes, Group group, vector<long long>& totals) const {
+        const int32_t* q = Quantities.data();
+        for (size_t i = 0; i < codes.size(); ++i) totals[group(codes[i])] += q[i];
+    }
+
+    // Appends the rows whose quantity is below threshold.
+    void lowStockRows(int threshold, vector<uint32_t>& rows) const {
+        const int32_t* q = Quantities.data();
+        size_t n = Quantities.size();
+        size_t i = 0;
+#ifdef __SSE2__
+        // Most rows are above the threshold, so whole blocks of four are skipped on a zero mask.
+        __m128i limit = _mm_set1_epi32(threshold);
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, limit)));
+            while (mask) {
+                int bit = __builtin_ctz(static_cast<unsigned>(mask));
+                rows.push_back(static_cast<uint32_t>(i + bit));
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            if (q[i] < threshold) rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Appends the rows last updated strictly before `since`.
+    void staleRows(time_t since, vector<uint32_t>& rows) const {
+        // Branch-free selection into a small block, appended once the block is done.
+        const int64_t* t = LastUpdated.data();
+        size_t n = LastUpdated.size();
+        int64_t limit = static_cast<int64_t>(since);
+        uint32_t block[1024];
+        for (size_t base = 0; base < n; base += 1024) {
+            size_t end = min(n, base + 1024);
+            size_t found = 0;
+            for (size_t i = base; i < end; ++i) {
+                block[found] = static_cast<uint32_t>(i);
+                found += t[i] < limit;
+            }
+            rows.insert(rows.end(), block, block + found);
+        }
+    }
+};
+
+// --- InventoryManager Class ---
+struct StockTotal {
+    InternedString Key;
+    long long Quantity;
+    size_t Items;
+};
+
+class InventoryManager {
+private:
+    SlotMap<Inventory> inventories;
+    IdIndex index;
+    int nextItemId = 1;
+    Journal* journal = nullptr;
+    optional<InventoryColumns> columns;
+    AttributeIndex byCategory;
+    AttributeIndex byLocation;
+    // Built by the first name search and kept up to date from then on, so restoring
+    // a snapshot or journal does not pay for it. Readers holding a shared repository
+    // lock may race to build it; namesMutex lets one of them do so.
+    mutable NameIndex names;
+    mutable atomic<bool> namesBuilt{false};
+    mutable mutex namesMutex;
+    ReportAggregates* aggregates = nullptr;
+    optional<VersionedRecords<Inventory>> versions;
+    const ReferenceIndex* openShipments = nullptr;
+
+    // Writers hold the repository exclusively, so no build can be running.
+    bool namesLive() const {
+        return namesBuilt.load(memory_order_relaxed);
+    }
+
+    void buildNames() const {
+        if (namesBuilt.load(memory_order_acquire)) return;
+        lock_guard<mutex> lock(namesMutex);
+        if (namesBuilt.load(memory_order_relaxed)) return;
+        names.clear();
+        names.reserve(inventories.size());
+        for (size_t i = 0; i < inventories.size(); ++i) {
+            names.add(inventories.handleAt(i).Index, inventories.view()[i].ItemName);
+        }
+        namesBuilt.store(true, memory_order_release);
+    }
+
+    void indexAttributes(const Inventory& item, SlotHandle h) {
+        byCategory.add(item.Category.code(), item.ItemId, h);
+        byLocation.add(item.Location.code(), item.ItemId, h);
+        if (namesLive()) names.add(h.Index, item.ItemName);
+        if (aggregates) aggregates->stock(item.Category.code(), item.Quantity, +1);
+        if (versions) versions->put(h.Index, item);
+    }
+
+    void unindexAttributes(const Inventory& item, SlotHandle h) {
+        byCategory.remove(item.Category.code(), h);
+        byLocation.remove(item.Location.code(), h);
+        if (namesLive()) names.remove(h.Index);
+        if (aggregates) aggregates->stock(item.Category.code(), item.Quantity, -1);
+        if (versions) versions->erase(h.Index);
+    }
+
+    // Tallies per live group of the attribute index, so the cost is O(items + groups)
+    // however many strings the dictionary holds.
+    vector<StockTotal> stockBy(InternedString Inventory::*field, const AttributeIndex& attribute,
+                               const pmr::vector<uint32_t>* codes) const {
+        const pmr::vector<uint32_t>& live = attribute.codes();
+        vector<long long> totals(live.size(), 0);
+        if (codes) {
+            columns->quantityBy(*codes, [&attribute](uint32_t code) { return attribute.group(code); }, totals);
+        } else {
+            for (const auto& item : inventories) totals[attribute.group((item.*field).code())] += item.Quantity;
+        }
+        vector<StockTotal> result;
+        result.reserve(live.size());
+        for (size_t g = 0; g < live.size(); ++g) {
+            result.push_back(StockTotal{StringDictionary::shared().text(live[g]), totals[g], attribute.postings(live[g]).size()});
+        }
+        sort(result.begin(), result.end(), [](const StockTotal& a, const StockTotal& b) { return a.Key.str() < b.Key.str(); });
+        return result;
+    }
+
+public:
+    explicit InventoryManager(pmr::memory_resource* resource = pmr::get_default_resource())
+        : inventories(resource), index(resource), byCategory(resource), byLocation(resource), names(resource) {}
+
+    void attachJournal(Journal* j) {
+        journal = j;
+    }
+
+    // Feeds the report totals; existing items are counted immediately.
+    void attachAggregates(ReportAggregates* a) {
+        aggregates = a;
+        if (!aggregates) return;
+        for (const auto& item : inventories) aggregates->stock(item.Category.code(), item.Quantity, +1);
+    }
+
+    // Items with an entry in `shipments` (item ID to open shipments) cannot be deleted.
+    void attachReferences(const ReferenceIndex* shipments) {
+        openShipments = shipments;
+    }
+
+    // True while an open shipment still references the item.
+    bool hasReferences(int itemId) const {
+        return openShipments && openShipments->contains(itemId);
+    }
+
+    bool addInventory(Inventory item) {
+        OperationTimer timer(MetricOp::AddInventory);
+        item.ItemId = nextItemId++;
+        if (journal) journal->log(JournalOp::AddInventory, item);
+        if (columns) columns->append(item);
+        item.ItemName.adopt(inventories.resource());
+        int id = item.ItemId;
+        SlotHandle h = inventories.insert(move(item));
+        index.insert(id, h);
+        indexAttributes(*inventories.get(h), h);
+        return true;
+    }
+
+    Inventory* searchInventory(int id) {
+        OperationTimer timer(MetricOp::SearchInventory);
+        const SlotHandle* h = index.find(id);
+        return h ? inventories.get(*h) : nullptr;
+    }
+
+    const Inventory* searchInventory(int id) const {
+        OperationTimer timer(MetricOp::SearchInventory);
+        const SlotHandle* h = index.find(id);
+        return h ? inventories.get(*h) : nullptr;
+    }
+
+    // Returns nullptr if the item behind the handle has been deleted.
+    Inventory* searchInventory(SlotHandle h) {
+        return inventories.get(h);
+    }
+
+    const Inventory* searchInventory(SlotHandle h) const {
+        return inventories.get(h);
+    }
+
+    SlotHandle inventoryHandle(int id) const {
+        const SlotHandle* h = index.find(id);
+        return h ? *h : SlotHandle();
+    }
+
+    bool editInventory(Inventory item) {
+        OperationTimer timer(MetricOp::EditInventory);
+        const SlotHandle* h = index.find(item.ItemId);
+        if (!h) return false;
+        Inventory* existing = inventories.get(*h);
+        byCategory.update(existing->Category.code(), item.Category.code(), item.ItemId, *h);
+        byLocation.update(existing->Location.code(), item.Location.code(), item.ItemId, *h);
+        if (aggregates) {
+            aggregates->stock(existing->Category.code(), existing->Quantity, -1);
+            aggregates->stock(item.Category.code(), item.Quantity, +1);
+        }
+        bool renamed = namesLive() && existing->ItemName.str() != item.ItemName.str();
+        if (renamed) names.remove(h->Index);
+        existing->ItemName = item.ItemName;
+        existing->ItemName.adopt(inventories.resource());
+        if (renamed) names.add(h->Index, existing->ItemName);
+        existing->Category = item.Category;
+        existing->Quantity = item.Quantity;
+        existing->Location = item.Location;
+        existing->LastUpdated = item.LastUpdated;
+        if (columns) columns->assign(inventories.denseIndex(*h), *existing);
+        if (versions) versions->put(h->Index, *existing);
+        if (journal) journal->log(JournalOp::EditInventory, *existing);
+        return true;
+    }
+
+    bool deleteInventory(int itemId) {
+        OperationTimer timer(MetricOp::DeleteInventory);
+        const SlotHandle* h = index.find(itemId);
+        if (!h || hasReferences(itemId)) return false;
+        if (columns) columns->removeRow(inventories.denseIndex(*h));
+        unindexAttributes(*inventories.get(*h), *h);
+        inventories.erase(*h);
+        index.erase(itemId);
+        if (journal) journal->logId(JournalOp::DeleteInventory, itemId);
+        return true;
+    }
+
+    // Adds delta to an item's quantity without journaling; the WarehouseBatch record
+    // that carries the change is journaled instead.
+    bool applyStock(int itemId, long long delta, time_t updated) {
+        const SlotHandle* h = index.find(itemId);
+        if (!h) return false;
+        Inventory* item = inventories.get(*h);
+        if (aggregates) aggregates->stock(item->Category.code(), item->Quantity, -1);
+        item->Quantity = static_cast<int>(item->Quantity + delta);
+        item->LastUpdated = updated;
+        if (aggregates) aggregates->stock(item->Category.code(), item->Quantity, +1);
+        if (columns) columns->assign(inventories.denseIndex(*h), *item);
+        if (versions) versions->put(h->Index, *item);
+        return true;
+    }
+
+    // Inserts a record that already carries its ID (snapshot and journal restore).
+    bool restoreInventory(Inventory record) {
+        int id = record.ItemId;
+        bool inserted = false;
+        SlotHandle& slot = index.slotFor(id, inserted);
+        if (!inserted) return false;
+        if (columns) columns->append(record);
+        record.ItemName.adopt(inventories.resource());
+        slot = inventories.insert(move(record));
+        indexAttributes(*inventories.get(slot), slot);
+        if (id >= nextItemId) nextItemId = id + 1;
+        return true;
+    }
+
+    RecordView<Inventory> records() const {
+        return inventories.view();
+    }
+
+    // Records, every index and the item names' text. Walks the names, so it costs
+    // O(items); meant for the metrics dump, not for hot paths.
+    size_t memoryBytes() const {
+        size_t bytes = inventories.bytesUsed() + index.bytesUsed() + byCategory.bytesUsed() + byLocation.bytesUsed();
+        if (namesBuilt.load(memory_order_acquire)) bytes += names.bytesUsed();
+        if (columns) bytes += columns->bytesUsed();
+        if (versions) bytes += versions->bytesUsed();
+        for (const auto& item : inventories) bytes += item.ItemName.bytesUsed();
+        return bytes;
+    }
+
+    // The resource records and their text are allocated from.
+    pmr::memory_resource* resource() const {
+        return inventories.resource();
+    }
+
+    void reserve(size_t n) {
+        inventories.reserve(n);
+        index.reserve(n);
+        byCategory.reserve(n);
+        byLocation.reserve(n);
+        if (columns) columns->reserve(n);
+    }
+
+    void prefetchId(int id) const {
+        index.prefetch(id);
+    }
+
+    // Keeps a columnar copy of the numeric fields so stock queries scan only those.
+    // Records must then be changed only through editInventory, not via searchInventory pointers.
+    void enableColumns() {
+        if (columns) return;
+        columns.emplace(inventories.resource());
+        columns->reserve(inventories.size());
+        for (const auto& item : inventories) columns->append(item);
+    }
+
+    void disableColumns() {
+        columns.reset();
+    }
+
+    bool hasColumns() const {
+        return columns.has_value();
+    }
+
+    // Keeps a copy-on-write version of the items that snapshot() can pin. Like the
+    // columns, this requires changing records only through the repository methods.
+    void enableVersions() {
+        if (versions) return;
+        versions.emplace(inventories.resource());
+        for (size_t i = 0; i < inventories.size(); ++i) {
+            versions->put(inventories.handleAt(i).Index, inventories.view()[i]);
+        }
+    }
+
+    // Consistent view of every item as of the last completed change; scanning it
+    // needs no lock and never delays writers. Empty unless enableVersions was called.
+    VersionedRecords<Inventory>::Snapshot snapshot() const {
+        return versions ? versions->snapshot() : VersionedRecords<Inventory>::Snapshot();
+    }
+
+    long long totalQuantity() const {
+        if (columns) return columns->totalQuantity();
+        long long total = 0;
+        for (const auto& item : inventories) total += item.Quantity;
+        return total;
+    }
+
+    vector<StockTotal> quantityByCategory() const {
+        return stockBy(&Inventory::Category, byCategory, columns ? &columns->Categories : nullptr);
+    }
+
+    vector<StockTotal> quantityByLocation() const {
+        return stockBy(&Inventory::Location, byLocation, columns ? &columns->Locations : nullptr);
+    }
+
+    // Calls fn for each item matching every given attribute; unset attributes match anything.
+    template <typename Fn>
+    size_t findInventory(const optional<string>& category, const optional<string>& location, Fn fn) const {
+        OperationTimer timer(MetricOp::FindInventory);
+        vector<AttributeFilter<Inventory>> filters;
+        if (!appendFilter(filters, byCategory, &Inventory::Category, category) ||
+            !appendFilter(filters, byLocation, &Inventory::Location, location)) {
+            return 0;
+        }
+        return forEachMatch(inventories, filters, fn);
+    }
+
+    // IDs of the best `limit` items whose name matches query, best first.
+    vector<int> searchByName(string_view query, NameMatch mode, size_t limit) const {
+        OperationTimer timer(MetricOp::SearchName);
+        buildNames();
+        vector<int> ids;
+        for (const NameIndex::Hit& hit : names.search(query, mode, limit)) {
+            ids.push_back(inventories.get(inventories.handleOfSlot(hit.Slot))->ItemId);
+        }
+        return ids;
+    }
+
+    const NameIndex& nameIndex() const {
+        buildNames();
+        return names;
+    }
+
+    // Words in the name index; 0 until the first name search builds it.
+    size_t nameVocabulary() const {
+        return namesBuilt.load(memory_order_acquire) ? names.vocabularySize() : 0;
+    }
+
+    // IDs of items whose quantity is below threshold.
+    vector<int> lowStockItems(int threshold) const {
+        vector<int> ids;
+        if (columns) {
+            vector<uint32_t> rows;
+            columns->lowStockRows(threshold, rows);
+            ids.reserve(rows.size());
+            for (uint32_t row : rows) ids.push_back(columns->ItemIds[row]);
+        } else {
+            for (const auto& item : inventories) {
+                if (item.Quantity < threshold) ids.push_back(item.ItemId);
+            }
+        }
+        return ids;
+    }
+
+    // IDs of items last updated before `since`.
+    vector<int> staleItems(time_t since) const {
+        vector<int> ids;
+        if (columns) {
+            vector<uint32_t> rows;
+            columns->staleRows(since, rows);
+            ids.reserve(rows.size());
+            for (uint32_t row : rows) ids.push_back(columns->ItemIds[row]);
+        } else {
+            for (const auto& item : inventories) {
+                if (item.LastUpdated < since) ids.push_back(item.ItemId);
+            }
+        }
+        return ids;
+    }
+
+    int nextId() const {
+        return nextItemId;
+    }
+
+    void setNextId(int id) {
+        if (id > nextItemId) nextItemId = id;
+    }
+
+    void addInventory() {
+        string name, category, location;
+        int quantity;
+
+        cout << "Enter Item Name: ";
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        getline(cin, name);
+
+        cout << "Enter Category: ";
+        getline(cin, category);
+
+        cout << "Enter Quantity: ";
+        cin >> quantity;
+        if (cin.fail()) {
+            cerr << "Invalid quantity input." << endl;
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return;
+        }
+
+        cout << "Enter Location: ";
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        getline(cin, location);
+
+        addInventory(Inventory(0, name, category, quantity, location));
+        cout << "Inventory item added successfully with ID: " << nextItemId - 1 << endl;
+    }
+
+    void viewInventory() const {
+        if (inventories.empty()) {
+            cout << "Inventory is empty." << endl;
+            return;
+        }
+        cout << "--- Inventory List ---" << endl;
+        RecordWriter out(cout);
+        for (const auto& item : inventories) {
+            item.render(out);
+        }
+    }
+
+    void searchInventory() const {
+        int itemId;
+        cout << "Enter Item ID to search: ";
+        cin >> itemId;
+        if (cin.fail()) {
+            cerr << "Invalid ID input." << endl;
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return;
+        }
+
+        if (const Inventory* item = searchInventory(itemId)) {
+            cout << "--- Item Found ---" << endl;
+            item->display();
+            return;
+        }
+        cout << "Inventory item with ID " << itemId << " not found." << endl;
+    }
+
+    void editInventory() {
+        int itemId;
+        cout << "Enter Item ID to edit: ";
+        cin >> itemId;
+        if (cin.fail()) {
+            cerr << "Invalid ID input." << endl;
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return;
+        }
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        const Inventory* existing = searchInventory(itemId);
+        if (!existing) {
+            cout << "Inventory item with ID " << itemId << " not found." << endl;
+            return;
+        }
+        Inventory item = *existing;
+
+        cout << "--- Editing Item ID: " << itemId << " ---" << endl;
+        cout << "Enter new Item Name (" << item.ItemName << "): ";
+        string name;
+        getline(cin, name);
+        if (!name.empty()) item.ItemName = name;
+
+        cout << "Enter new Category (" << item.Category << "): ";
+        string category;
+        getline(cin, category);
+        if (!category.empty()) item.Category = category;
+
+        cout << "Enter new Quantity (" << item.Quantity << "): ";
+        int quantity;
+        cin >> quantity;
+        if (!cin.fail()) item.Quantity = quantity;
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        cout << "Enter new Location (" << item.Location << "): ";
+        string location;
+        getline(cin, location);
+        if (!location.empty()) item.Location = location;
+
+        item.LastUpdated = time(nullptr);
+        editInventory(item);
+        cout << "Inventory item with ID " << itemId << " updated." << endl;
+    }
+
+    void deleteInventory() {
+        int itemId;
+        cout << "Enter Item ID to delete: ";
+        cin >> itemId;
+        if (cin.fail()) {
+            cerr << "Invalid ID input." << endl;
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return;
+        }
+
+        if (hasReferences(itemId)) {
+            cout << "Inventory item with ID " << itemId << " has open shipment(s):";
+            openShipments->forEach(itemId, [](const ReferenceIndex::Posting& posting) { cout << ' ' << posting.Id; });
+            cout << "\nDeliver or remove them before deleting the item." << endl;
+        } else if (deleteInventory(itemId)) {
+            cout << "Inventory item with ID " << itemId << " deleted." << endl;
+        } else {
+            cout << "Inventory item with ID " << itemId << " not found." << endl;
+        }
+    }
+
+    void stockLevels() const {
+        cout << "--- Stock Levels ---" << endl;
+        cout << "Items: " << inventories.size() << ", total quantity: " << totalQuantity() << endl;
+        cout << "By category:" << endl;
+        for (const auto& t : quantityByCategory()) {
+            cout << "  " << (t.Key.empty() ? "(none)" : t.Key.str()) << ": " << t.Quantity << " in " << t.Items << " item(s)\n";
+        }
+        cout << "By location:" << endl;
+        for (const auto& t : quantityByLocation()) {
+            cout << "  " << (t.Key.empty() ? "(none)" : t.Key.str()) << ": " << t.Quantity << " in " << t.Items << " item(s)\n";
+        }
+        cout << flush;
+    }
+
+    void listItems(const vector<int>& ids, const string& empty) const {
+        if (ids.empty()) {
+            cout << empty << endl;
+            return;
+        }
+        RecordWriter out(cout);
+        for (int id : ids) inventories.get(inventoryHandle(id))->render(out);
+    }
+
+    void lowStockReport() const {
+        int threshold;
+        cout << "Enter low-stock threshold: ";
+        cin >> threshold;
+        if (cin.fail()) {
+            cerr << "Invalid threshold input." << endl;
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return;
+        }
+        listItems(lowStockItems(threshold), "No items below " + to_string(threshold) + ".");
+    }
+
+    void staleItemsReport() const {
+        int days;
+        cout << "Enter number of days without an update: ";
+        cin >> days;
+        if (cin.fail() || days < 0) {
+            cerr << "Invalid days input." << endl;
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return;
+        }
+        listItems(staleItems(time(nullptr) - static_cast<time_t>(days) * 24 * 3600),
+                  "Every item was updated in the last " + to_string(days) + " day(s).");
+    }
+
+    void findItems() const {
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        optional<string> category = readFilter("Category");
+        optional<string> location = readFilter("Location");
+        size_t found;
+        {
+            RecordWriter out(cout);
+            found = findInventory(category, location, [&out](const Inventory& item) { item.render(out); });
+        }
+        cout << found << " item(s) found." << endl;
+    }
+
+    void searchByName() const {
+        string query, mode;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cout << "Enter name or part of it: ";
+        getline(cin, query);
+        cout << "Match (prefix/substring/fuzzy, default fuzzy): ";
+        getline(cin, mode);
+        NameMatch match = NameMatch::Fuzzy;
+        if (mode == "prefix") {
+            match = NameMatch::Prefix;
+        } else if (mode == "substring") {
+            match = NameMatch::Substring;
+        } else if (!mode.empty() && mode != "fuzzy") {
+            cerr << "Unknown match type: " << mode << endl;
+            return;
+        }
+        listItems(searchByName(query, match, 20), "No item names match \"" + query + "\".");
+    }
+
+    void inventorySubMenu() {
+        int choice;
+        do {
+            cout << "\n--- Inventory Management ---" << endl;
+            cout << "1. Add Item" << endl;
+            cout << "2. View Items" << endl;
+            cout << "3. Search Item" << endl;
+            cout << "4. Edit Item" << endl;
+            cout << "5. Delete Item" << endl;
+            cout << "6. Stock Levels" << endl;
+            cout << "7. Low Stock Items" << endl;
+            cout << "8. Items Not Updated Recently" << endl;
+            cout << "9. Find Items" << endl;
+            cout << "10. Search by Name" << endl;
+            cout << "0. Back to Main Menu" << endl;
+            cout << "Enter your choice: ";
+            cin >> choice;
+
+            if (cin.fail()) {
+                cerr << "Invalid input. Please enter a number." << endl;
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                choice = -1;
+                continue;
+            }
+
+            switch (choice) {
+                case 1:
+                    addInventory();
+                    break;
+                case 2:
+                    viewInventory();
+                    break;
+                case 3:
+                    searchInventory();
+                    break;
+                case 4:
+                    editInventory();
+                    break;
+                case 5:
+                    deleteInventory();
+                    break;
+                case 6:
+                    stockLevels();
+                    break;
+                case 7:
+                    lowStockReport();
+                    break;
+                case 8:
+                    staleItemsReport();
+                    break;
+                case 9:
+                    findItems();
+                    break;
+                case 10:
+                    searchByName();
+                    break;
+                case 0:
+                    cout << "Returning to Main Menu." << endl;
+                    break;
+                default:
+                    cout << "Invalid choice. Please try again." << endl;
+            }
+        } while (choice != 0);
+    }
+};
+
+// --- Maintenance Class ---
+// Packed like Inventory: 32 bytes with the description out of line and the status,
+// which takes only a handful of values, interned.
+class alignas(32) Maintenance {
+public:
+    int ScheduleId;
+    int EquipmentId;
+    time_t ScheduledDate;
+    InternedString CompletionStatus;
+    HeapString Description;
+
+    Maintenance(int scheduleId = 0, int equipmentId = 0, HeapString description = {}, time_t scheduledDate = 0, InternedString completionStatus = {})
+        : ScheduleId(scheduleId), EquipmentId(equipmentId), ScheduledDate(scheduledDate), CompletionStatus(completionStatus), Description(move(description)) {}
+
+    // "Completed", "Complete" and "Done" (any case) close a schedule; anything else is open.
+    bool isCompleted() const {
+        static const char* closed[] = {"completed", "complete", "done"};
+        const string& status = CompletionStatus.str();
+        for (const char* word : closed) {
+            if (status.size() == strlen(word) &&
+                equal(status.begin(), status.end(), word,
+                      [](char a, char b) { return tolower(static_cast<unsigned char>(a)) == b; })) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void render(RecordWriter& out) const {
+        out.beginRecord("maintenance");
+        out.field("Schedule ID", "ScheduleId", ScheduleId);
+        out.field("Equipment ID", "EquipmentId", EquipmentId);
+        out.field("Description", "Description", Description);
+        out.timeField("Scheduled Date", "ScheduledDate", ScheduledDate);
+        out.field("Completion Status", "CompletionStatus", CompletionStatus);
+        out.endRecord();
+    }
+
+    void display() const {
+        RecordWriter out(cout);
+        render(out);
+    }
+
+    void writeTo(ByteWriter& out) const {
+        out.putI32(ScheduleId);
+        out.putI32(EquipmentId);
+        out.putString(Description);
+        out.putI64(ScheduledDate);
+        out.putString(CompletionStatus);
+    }
+
+    static Maintenance readFrom(ByteReader& in) {
+        Maintenance m;
+        m.ScheduleId = in.getI32();
+        m.EquipmentId = in.getI32();
+        m.Description = in.getString();
+        m.ScheduledDate = static_cast<time_t>(in.getI64());
+        m.CompletionStatus = in.getString();
+        return m;
+    }
+};
+
+// --- MaintenanceRepository Class ---
+class MaintenanceRepository {
+private:
+    SlotMap<Maintenance> maintenances;
+    IdIndex index;
+    int nextScheduleId = 1;
+    Journal* journal = nullptr;
+    ReportAggregates* aggregates = nullptr;
+    // Open (not completed) schedules ordered by (ScheduledDate, ScheduleId).
+    pmr::set<pair<time_t, int>> calendar;
+
+    void trackSchedule(const Maintenance& m) {
+        if (!m.isCompleted()) calendar.emplace(m.ScheduledDate, m.ScheduleId);
+        if (aggregates) aggregates->maintenance(m.isCompleted(), +1);
+    }
+
+    void untrackSchedule(const Maintenance& m) {
+        calendar.erase(make_pair(m.ScheduledDate, m.ScheduleId));
+        if (aggregates) aggregates->maintenance(m.isCompleted(), -1);
+    }
+
+    // Shared by updateSchedule and completeNextDue; the caller does the timing.
+    bool replaceSchedule(const Maintenance& b) {
+        if (Maintenance* m = maintenances.get(scheduleHandle(b.ScheduleId))) {
+            untrackSchedule(*m);
+            m->EquipmentId = b.EquipmentId;
+            m->Description = b.Description;
+            m->Description.adopt(maintenances.resource());
+            m->ScheduledDate = b.ScheduledDate;
+            m->CompletionStatus = b.CompletionStatus;
+            trackSchedule(*m);
+            if (journal) journal->log(JournalOp::UpdateSchedule, *m);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename Fn>
+    size_t walkCalendar(time_t from, time_t to, Fn fn) const {
+        size_t count = 0;
+        for (auto it = calendar.lower_bound(make_pair(from, numeric_limits<int>::min()));
+             it != calendar.end() && it->first < to; ++it) {
+            fn(*maintenances.get(scheduleHandle(it->second)));
+            count++;
+        }
+        return count;
+    }
+
+public:
+    explicit MaintenanceRepository(pmr::memory_resource* resource = pmr::get_default_resource())
+        : maintenances(resource), index(resource), calendar(resource) {}
+
+    void attachJournal(Journal* j) {
+        journal = j;
+    }
+
+    // Feeds the report totals; existing schedules are counted immediately.
+    void attachAggregates(ReportAggregates* a) {
+        aggregates = a;
+        if (!aggregates) return;
+        for (const auto& m : maintenances) aggregates->maintenance(m.isCompleted(), +1);
+    }
+
+    bool scheduleMaintenance(Maintenance b) {
+        OperationTimer timer(MetricOp::ScheduleMaintenance);
+        b.ScheduleId = nextScheduleId++;
+        if (journal) journal->log(JournalOp::ScheduleMaintenance, b);
+        trackSchedule(b);
+        b.Description.adopt(maintenances.resource());
+        index.insert(b.ScheduleId, maintenances.insert(move(b)));
+        return true;
+    }
+
+    bool updateSchedule(Maintenance b) {
+        OperationTimer timer(MetricOp::UpdateSchedule);
+        return replaceSchedule(b);
+    }
+
+    bool removeMaintenance(int scheduleId) {
+        OperationTimer timer(MetricOp::RemoveMaintenance);
+        const SlotHandle* h = index.find(scheduleId);
+        if (!h) return false;
+        untrackSchedule(*maintenances.get(*h));
+        maintenances.erase(*h);
+        index.erase(scheduleId);
+        if (journal) journal->logId(JournalOp::RemoveMaintenance, scheduleId);
+        return true;
+    }
+
+    Maintenance* viewSchedule(int id) {
+        OperationTimer timer(MetricOp::ViewSchedule);
+        const SlotHandle* h = index.find(id);
+        return h ? maintenances.get(*h) : nullptr;
+    }
+
+    // Returns nullptr if the schedule behind the handle has been removed.
+    Maintenance* viewSchedule(SlotHandle h) {
+        return maintenances.get(h);
+    }
+
+    SlotHandle scheduleHandle(int id) const {
+        const SlotHandle* h = index.find(id);
+        return h ? *h : SlotHandle();
+    }
+
+    // Inserts a record that already carries its ID (snapshot and journal restore).
+    bool restoreMaintenance(Maintenance record) {
+        int id = record.ScheduleId;
+        bool inserted = false;
+        SlotHandle& slot = index.slotFor(id, inserted);
+        if (!inserted) return false;
+        trackSchedule(record);
+        record.Description.adopt(maintenances.resource());
+        slot = maintenances.insert(move(record));
+        if (id >= nextScheduleId) nextScheduleId = id + 1;
+        return true;
+    }
+
+    RecordView<Maintenance> records() const {
+        return maintenances.view();
+    }
+
+    // Records, ID index, calendar and description text; O(schedules).
+    size_t memoryBytes() const {
+        size_t bytes = maintenances.bytesUsed() + index.bytesUsed() + nodeBytes(calendar);
+        for (const auto& m : maintenances) bytes += m.Description.bytesUsed();
+        return bytes;
+    }
+
+    // The resource records and their text are allocated from.
+    pmr::memory_resource* resource() const {
+        return maintenances.resource();
+    }
+
+    void reserve(size_t n) {
+        maintenances.reserve(n);
+        index.reserve(n);
+    }
+
+    void prefetchId(int id) const {
+        index.prefetch(id);
+    }
+
+    int nextId() const {
+        return nextScheduleId;
+    }
+
+    void setNextId(int id) {
+        if (id > nextScheduleId) nextScheduleId = id;
+    }
+
+    RecordView<Maintenance> viewAll() const {
+        return maintenances.view();
+    }
+
+    const Maintenance* viewSchedule(int id) const {
+        OperationTimer timer(MetricOp::ViewSchedule);
+        const SlotHandle* h = index.find(id);
+        return h ? maintenances.get(*h) : nullptr;
+    }
+
+    // Calls fn, in date order, for each open schedule with from <= ScheduledDate < to.
+    template <typename Fn>
+    size_t dueBetween(time_t from, time_t to, Fn fn) const {
+        OperationTimer timer(MetricOp::DueBetween);
+        return walkCalendar(from, to, fn);
+    }
+
+    // Open schedules whose date is before now.
+    template <typename Fn>
+    size_t overdue(time_t now, Fn fn) const {
+        OperationTimer timer(MetricOp::OverdueSchedules);
+        return walkCalendar(numeric_limits<time_t>::min(), now, fn);
+    }
+
+    size_t openCount() const {
+        return calendar.size();
+    }
+
+    // The earliest open schedule, or nullptr when nothing is open.
+    const Maintenance* nextDue() const {
+        OperationTimer timer(MetricOp::NextDue);
+        return calendar.empty() ? nullptr : maintenances.get(scheduleHandle(calendar.begin()->second));
+    }
+
+    // Marks the earliest open schedule due by `now` as completed and returns its ID (0 if none).
+    int completeNextDue(time_t now) {
+        OperationTimer timer(MetricOp::CompleteNextDue);
+        if (calendar.empty() || calendar.begin()->first > now) return 0;
+        Maintenance done = *maintenances.get(scheduleHandle(calendar.begin()->second));
+        done.CompletionStatus = "Completed";
+        replaceSchedule(done);
+        return done.ScheduleId;
+    }
+
+    void maintenanceSubMenu() {
+        int choice;
+        do {
+            cout << "\n--- Maintenance Management ---" << endl;
+            cout << "1. Schedule Maintenance" << endl;
+            cout << "2. View All Schedules" << endl;
+            cout << "3. View Schedule Details" << endl;
+            cout << "4. Update Schedule" << endl;
+            cout << "5. Remove Schedule" << endl;
+            cout << "6. Due in Next 24 Hours" << endl;
+            cout << "7. Overdue Schedules" << endl;
+            cout << "8. Complete Next Due" << endl;
+            cout << "0. Back to Main Menu" << endl;
+            cout << "Enter your choice: ";
+            cin >> choice;
+
+            if (cin.fail()) {
+                cerr << "Invalid input. Please enter a number." << endl;
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                choice = -1;
+                continue;
+            }
+
+            switch (choice) {
+                case 1: {
+                    int equipmentId;
+                    string description, completionStatus;
+                    time_t scheduledDate = time(nullptr); // Default to now
+
+                    cout << "Enter Equipment ID: ";
+                    cin >> equipmentId;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Enter Description: ";
+                    getline(cin, description);
+                    cout << "Enter Completion Status: ";
+                    getline(cin, completionStatus);
+                    string date;
+                    cout << "Enter Scheduled Date (YYYY-MM-DD [HH:MM:SS], blank for now): ";
+                    getline(cin, date);
+                    if (!date.empty() && !TimestampFormatter::parse(date, scheduledDate)) {
+                        cerr << "Invalid date input." << endl;
+                        break;
+                    }
+
+                    Maintenance newMaintenance(0, equipmentId, description, scheduledDate, completionStatus);
+                    if (scheduleMaintenance(newMaintenance)) {
+                        cout << "Maintenance scheduled successfully." << endl;
+                    } else {
+                        cout << "Failed to schedule maintenance." << endl;
+                    }
+                    break;
+                }
+                case 2: {
+                    RecordWriter out(cout);
+                    for (const auto& m : viewAll()) {
+                        m.render(out);
+                    }
+                    break;
+                }
+                case 3: {
+                    int scheduleId;
+                    cout << "Enter Schedule ID to view: ";
+                    cin >> scheduleId;
+                    if (auto maintenance = viewSchedule(scheduleId)) {
+                        maintenance->display();
+                    } else {
+                        cout << "Schedule with ID " << scheduleId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 4: {
+                    int scheduleId, equipmentId;
+                    string description, completionStatus;
+                    time_t scheduledDate = time(nullptr);
+
+                    cout << "Enter Schedule ID to update: ";
+                    cin >> scheduleId;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Enter new Equipment ID: ";
+                    cin >> equipmentId;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Enter new Description: ";
+                    getline(cin, description);
+                    cout << "Enter new Completion Status: ";
+                    getline(cin, completionStatus);
+                    string date;
+                    cout << "Enter new Scheduled Date (YYYY-MM-DD [HH:MM:SS], blank to keep): ";
+                    getline(cin, date);
+                    if (date.empty()) {
+                        if (const Maintenance* current = viewSchedule(scheduleId)) scheduledDate = current->ScheduledDate;
+                    } else if (!TimestampFormatter::parse(date, scheduledDate)) {
+                        cerr << "Invalid date input." << endl;
+                        break;
+                    }
+
+                    Maintenance updatedMaintenance(scheduleId, equipmentId, description, scheduledDate, completionStatus);
+                    if (updateSchedule(updatedMaintenance)) {
+                        cout << "Schedule updated successfully." << endl;
+                    } else {
+                        cout << "Failed to update schedule." << endl;
+                    }
+                    break;
+                }
+                case 5: {
+                    int scheduleId;
+                    cout << "Enter Schedule ID to remove: ";
+                    cin >> scheduleId;
+                    if (removeMaintenance(scheduleId)) {
+                        cout << "Schedule removed successfully." << endl;
+                    } else {
+                        cout << "Schedule with ID " << scheduleId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 6:
+                case 7: {
+                    time_t now = time(nullptr);
+                    size_t found;
+                    {
+                        RecordWriter out(cout);
+                        auto render = [&out](const Maintenance& m) { m.render(out); };
+                        found = choice == 6 ? dueBetween(now, now + 24 * 3600, render) : overdue(now, render);
+                    }
+                    cout << found << (choice == 6 ? " schedule(s) due in the next 24 hours." : " overdue schedule(s).") << endl;
+                    break;
+                }
+                case 8:
+                    if (int id = completeNextDue(time(nullptr))) {
+                        cout << "Schedule " << id << " marked as completed." << endl;
+                    } else {
+                        cout << "Nothing is due." << endl;
+                    }
+                    break;
+                case 0:
+                    cout << "Returning to Main Menu." << endl;
+                    break;
+                default:
+                    cout << "Invalid choice. Please try again." << endl;
+            }
+        } while (choice != 0);
+    }
+};
+
+// --- Report Class ---
+class Report {
+public:
+    int ReportId;
+    string ReportType;
+    time_t GeneratedOn;
+    string Details;
+
+    Report(int reportId = 0, string reportType = "", time_t generatedOn = 0, string details = "")
+        : ReportId(reportId), ReportType(move(reportType)), GeneratedOn(generatedOn), Details(move(details)) {}
+
+    void render(RecordWriter& out) const {
+        out.beginRecord("report");
+        out.field("Report ID", "ReportId", ReportId);
+        out.field("Report Type", "ReportType", ReportType);
+        out.timeField("Generated On", "GeneratedOn", GeneratedOn);
+        out.field("Details", "Details", Details);
+        out.endRecord();
+    }
+
+    void display() const {
+        RecordWriter out(cout);
+        render(out);
+    }
+
+    void writeTo(ByteWriter& out) const {
+        out.putI32(ReportId);
+        out.putString(ReportType);
+        out.putI64(GeneratedOn);
+        out.putString(Details);
+    }
+
+    static Report readFrom(ByteReader& in) {
+        Report r;
+        r.ReportId = in.getI32();
+        r.ReportType = in.getString();
+        r.GeneratedOn = static_cast<time_t>(in.getI64());
+        r.Details = in.getString();
+        return r;
+    }
+};
+
+// --- ReportRepository Class ---
+class ReportRepository {
+private:
+    SlotMap<Report> reports;
+    IdIndex index;
+    int nextReportId = 1;
+    Journal* journal = nullptr;
+    ReportAggregates totals;
+
+    // Built-in report types are recomputed from the running totals.
+    void refresh(Report& report) const {
+        int type = ReportAggregates::builtInIndex(report.ReportType);
+        if (type >= 0) {
+            report.Details = totals.details(type);
+            report.GeneratedOn = time(nullptr);
+        }
+    }
+
+    // The stored record is left alone; callers get a copy with current figures.
+    optional<Report> current(const Report* stored) const {
+        if (!stored) return nullopt;
+        Report copy = *stored;
+        refresh(copy);
+        return copy;
+    }
+
+public:
+    explicit ReportRepository(pmr::memory_resource* resource = pmr::get_default_resource())
+        : reports(resource), index(resource), totals(resource) {}
+
+    ReportAggregates& aggregates() {
+        return totals;
+    }
+
+    void attachJournal(Journal* j) {
+        journal = j;
+    }
+
+    bool generateReport(Report a) {
+        OperationTimer timer(MetricOp::GenerateReport);
+        a.ReportId = nextReportId++;
+        refresh(a);
+        if (journal) journal->log(JournalOp::GenerateReport, a);
+        index.insert(a.ReportId, reports.insert(move(a)));
+        return true;
+    }
+
+    // Built-in reports come back with current figures.
+    optional<Report> downloadReport(int id) const {
+        OperationTimer timer(MetricOp::DownloadReport);
+        const SlotHandle* h = index.find(id);
+        return h ? current(reports.get(*h)) : nullopt;
+    }
+
+    // Returns nullopt if the report behind the handle no longer exists.
+    optional<Report> downloadReport(SlotHandle h) const {
+        return current(reports.get(h));
+    }
+
+    SlotHandle reportHandle(int id) const {
+        const SlotHandle* h = index.find(id);
+        return h ? *h : SlotHandle();
+    }
+
+    // Inserts a record that already carries its ID (snapshot and journal restore).
+    bool restoreReport(Report record) {
+        int id = record.ReportId;
+        bool inserted = false;
+        SlotHandle& slot = index.slotFor(id, inserted);
+        if (!inserted) return false;
+        slot = reports.insert(move(record));
+        if (id >= nextReportId) nextReportId = id + 1;
+        return true;
+    }
+
+    RecordView<Report> records() const {
+        return reports.view();
+    }
+
+    // Records, ID index, running totals and report text; O(reports).
+    size_t memoryBytes() const {
+        size_t bytes = reports.bytesUsed() + index.bytesUsed() + totals.bytesUsed();
+        for (const auto& r : reports) bytes += heapBytes(r.ReportType) + heapBytes(r.Details);
+        return bytes;
+    }
+
+    void reserve(size_t n) {
+        reports.reserve(n);
+        index.reserve(n);
+    }
+
+    void prefetchId(int id) const {
+        index.prefetch(id);
+    }
+
+    int nextId() const {
+        return nextReportId;
+    }
+
+    void setNextId(int id) {
+        if (id > nextReportId) nextReportId = id;
+    }
+
+    RecordView<Report> viewReports() const {
+        return reports.view();
+    }
+
+    void reportSubMenu() {
+        int choice;
+        do {
+            cout << "\n--- Report Management ---" << endl;
+            cout << "1. Generate Report" << endl;
+            cout << "2. View All Reports" << endl;
+            cout << "3. Download Report" << endl;
+            cout << "0. Back to Main Menu" << endl;
+            cout << "Enter your choice: ";
+            cin >> choice;
+
+            if (cin.fail()) {
+                cerr << "Invalid input. Please enter a number." << endl;
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                choice = -1;
+                continue;
+            }
+
+            switch (choice) {
+                case 1: {
+                    string reportType, details;
+                    time_t generatedOn = time(nullptr);
+
+                    cout << "Built-in types:";
+                    for (const auto& type : ReportAggregates::builtInTypes()) cout << " [" << type << "]";
+                    cout << endl;
+                    cout << "Enter Report Type: ";
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    getline(cin, reportType);
+                    if (ReportAggregates::builtInIndex(reportType) < 0) {
+                        cout << "Enter Report Details: ";
+                        getline(cin, details);
+                    }
+
+                    Report newReport(0, reportType, generatedOn, details);
+                    if (generateReport(newReport)) {
+                        cout << "Report generated successfully." << endl;
+                    } else {
+                        cout << "Failed to generate report." << endl;
+                    }
+                    break;
+                }
+                case 2: {
+                    RecordWriter out(cout);
+                    for (const auto& r : viewReports()) {
+                        r.render(out);
+                    }
+                    break;
+                }
+                case 3: {
+                    int reportId;
+                    cout << "Enter Report ID to download: ";
+                    cin >> reportId;
+                    if (auto report = downloadReport(reportId)) {
+                        report->display();
+                    } else {
+                        cout << "Report with ID " << reportId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 0:
+                    cout << "Returning to Main Menu." << endl;
+                    break;
+                default:
+                    cout << "Invalid choice. Please try again." << endl;
+            }
+        } while (choice != 0);
+    }
+};
+
+// --- Shipment Class ---
+class Shipment {
+public:
+    int ShipmentId;
+    int ItemId;
+    InternedString Origin;
+    InternedString Destination;
+    InternedString Status;
+    time_t ExpectedDelivery;
+    // The referenced item, resolved by ShipmentRepository when an InventoryManager is
+    // attached. Stays valid as the item table grows and goes stale, rather than
+    // dangling, once the item is deleted. Not persisted: ItemId is the stored key.
+    SlotHandle Item;
+
+    Shipment(int shipmentId = 0, int itemId = 0, InternedString origin = {}, InternedString destination = {}, InternedString status = {}, time_t expectedDelivery = 0)
+        : ShipmentId(shipmentId), ItemId(itemId), Origin(origin), Destination(destination), Status(status), ExpectedDelivery(expectedDelivery) {}
+
+    // A "delivered" status (any case) means the shipment can no longer be late.
+    bool isDelivered() const {
+        const string& text = Status.str();
+        return text.size() == 9 && equal(text.begin(), text.end(), "delivered",
+                                         [](char a, char b) { return tolower(static_cast<unsigned char>(a)) == b; });
+    }
+
+    void render(RecordWriter& out) const {
+        render(out, nullptr, false);
+    }
+
+    // Listing form joined with the referenced item; the item fields are blank once
+    // the item has been deleted.
+    void render(RecordWriter& out, const Inventory* item) const {
+        render(out, item, true);
+    }
+
+    void display() const {
+        RecordWriter out(cout);
+        render(out);
+    }
+
+    void writeTo(ByteWriter& out) const {
+        out.putI32(ShipmentId);
+        out.putI32(ItemId);
+        out.putString(Origin);
+        out.putString(Destination);
+        out.putString(Status);
+        out.putI64(ExpectedDelivery);
+    }
+
+    static Shipment readFrom(ByteReader& in) {
+        Shipment s;
+        s.ShipmentId = in.getI32();
+        s.ItemId = in.getI32();
+        s.Origin = in.getString();
+        s.Destination = in.getString();
+        s.Status = in.getString();
+        s.ExpectedDelivery = static_cast<time_t>(in.getI64());
+        return s;
+    }
+
+private:
+    void render(RecordWriter& out, const Inventory* item, bool withItem) const {
+        out.beginRecord("shipment");
+        out.field("Shipment ID", "ShipmentId", ShipmentId);
+        out.field("Item ID", "ItemId", ItemId);
+        if (withItem) {
+            out.field("Item Name", "ItemName", item ? item->ItemName.str() : string());
+            out.field("Item Category", "ItemCategory", item ? item->Category.str() : string());
+            out.field("Item Quantity", "ItemQuantity", item ? item->Quantity : 0);
+        }
+        out.field("Origin", "Origin", Origin);
+        out.field("Destination", "Destination", Destination);
+        out.field("Status", "Status", Status);
+        out.timeField("Expected Delivery", "ExpectedDelivery", ExpectedDelivery);
+        out.endRecord();
+    }
+};
+
+// --- ShipmentRepository Class ---
+class ShipmentRepository {
+private:
+    SlotMap<Shipment> shipments;
+    IdIndex index;
+    int nextShipmentId = 1;
+    Journal* journal = nullptr;
+    AttributeIndex byStatus;
+    AttributeIndex byOrigin;
+    AttributeIndex byDestination;
+    ReportAggregates* aggregates = nullptr;
+    optional<VersionedRecords<Shipment>> versions;
+    const InventoryManager* inventory = nullptr;
+    ReferenceIndex openByItem;
+    bool linksDeferred = false;
+    // Every shipment by (ExpectedDelivery, ShipmentId), and the undelivered ones whose
+    // deadline is before overdueClock. advanceClock moves newly late shipments across.
+    pmr::set<pair<time_t, int>> deliveries;
+    pmr::set<pair<time_t, int>> overdueSet;
+    time_t overdueClock = numeric_limits<time_t>::min();
+
+    void trackDelivery(const Shipment& s) {
+        deliveries.emplace_hint(deliveries.end(), s.ExpectedDelivery, s.ShipmentId);
+        if (!s.isDelivered() && s.ExpectedDelivery < overdueClock) overdueSet.emplace(s.ExpectedDelivery, s.ShipmentId);
+    }
+
+    void untrackDelivery(const Shipment& s) {
+        deliveries.erase(make_pair(s.ExpectedDelivery, s.ShipmentId));
+        overdueSet.erase(make_pair(s.ExpectedDelivery, s.ShipmentId));
+    }
+
+    void indexAttributes(const Shipment& s, SlotHandle h) {
+        byStatus.add(s.Status.code(), s.ShipmentId, h);
+        byOrigin.add(s.Origin.code(), s.ShipmentId, h);
+        byDestination.add(s.Destination.code(), s.ShipmentId, h);
+        if (!s.isDelivered() && !linksDeferred) openByItem.add(s.ItemId, s.ShipmentId, h);
+        if (aggregates) aggregates->shipment(s.Status.code(), +1);
+        if (versions) versions->put(h.Index, s);
+    }
+
+    void unindexAttributes(const Shipment& s, SlotHandle h) {
+        byStatus.remove(s.Status.code(), h);
+        byOrigin.remove(s.Origin.code(), h);
+        byDestination.remove(s.Destination.code(), h);
+        if (!s.isDelivered()) openByItem.remove(s.ItemId, h);
+        if (aggregates) aggregates->shipment(s.Status.code(), -1);
+        if (versions) versions->erase(h.Index);
+    }
+
+public:
+    explicit ShipmentRepository(pmr::memory_resource* resource = pmr::get_default_resource())
+        : shipments(resource), index(resource), byStatus(resource), byOrigin(resource), byDestination(resource),
+          openByItem(resource), deliveries(resource), overdueSet(resource) {}
+
+    void attachJournal(Journal* j) {
+        journal = j;
+    }
+
+    // Feeds the report totals; existing shipments are counted immediately.
+    void attachAggregates(ReportAggregates* a) {
+        aggregates = a;
+        if (!aggregates) return;
+        for (const auto& sh : shipments) aggregates->shipment(sh.Status.code(), +1);
+    }
+
+    // Resolves each shipment's item through `items`; from then on a shipment may only
+    // be received or re-pointed for an item that exists.
+    void attachInventory(const InventoryManager* items) {
+        inventory = items;
+        for (size_t i = 0; i < shipments.size(); ++i) {
+            Shipment* s = shipments.get(shipments.handleAt(i));
+            s->Item = inventory ? inventory->inventoryHandle(s->ItemId) : SlotHandle();
+        }
+    }
+
+    // Item ID to open (undelivered) shipments, for referential checks on the item side.
+    const ReferenceIndex& itemReferences() const {
+        return openByItem;
+    }
+
+    bool receiveShipment(Shipment shipment) {
+        OperationTimer timer(MetricOp::ReceiveShipment);
+        if (inventory) {
+            shipment.Item = inventory->inventoryHandle(shipment.ItemId);
+            if (shipment.Item == SlotHandle()) return false;
+        }
+        shipment.ShipmentId = nextShipmentId++;
+        if (journal) journal->log(JournalOp::ReceiveShipment, shipment);
+        int id = shipment.ShipmentId;
+        trackDelivery(shipment);
+        SlotHandle h = shipments.insert(move(shipment));
+        index.insert(id, h);
+        indexAttributes(*shipments.get(h), h);
+        return true;
+    }
+
+    bool removeShipment(int shipmentId) {
+        OperationTimer timer(MetricOp::RemoveShipment);
+        const SlotHandle* h = index.find(shipmentId);
+        if (!h) return false;
+        unindexAttributes(*shipments.get(*h), *h);
+        untrackDelivery(*shipments.get(*h));
+        shipments.erase(*h);
+        index.erase(shipmentId);
+        if (journal) journal->logId(JournalOp::RemoveShipment, shipmentId);
+        return true;
+    }
+
+    // Removes every shipment whose status matches (case-insensitively) in a single pass.
+    // Each distinct status code is compared as text once; the rest are integer lookups.
+    size_t expireShipments(const string& status) {
+        OperationTimer timer(MetricOp::ExpireShipments);
+        vector<int8_t> verdicts;
+        auto matches = [&status, &verdicts](const Shipment& s) {
+            uint32_t code = s.Status.code();
+            if (code >= verdicts.size()) verdicts.resize(code + 1, -1);
+            if (verdicts[code] < 0) {
+                const string& text = s.Status.str();
+                verdicts[code] = text.size() == status.size() &&
+                                 equal(text.begin(), text.end(), status.begin(),
+                                       [](char a, char b) { return tolower(static_cast<unsigned char>(a)) == tolower(static_cast<unsigned char>(b)); });
+            }
+            return verdicts[code] == 1;
+        };
+        size_t removed = shipments.eraseIf(matches, [this](const Shipment& s) {
+            unindexAttributes(s, *index.find(s.ShipmentId));
+            untrackDelivery(s);
+            index.erase(s.ShipmentId);
+        });
+        if (journal && removed) journal->logText(JournalOp::ExpireShipments, status);
+        return removed;
+    }
+
+    bool dispatchShipment(Shipment shipment) {
+        OperationTimer timer(MetricOp::DispatchShipment);
+        const SlotHandle* h = index.find(shipment.ShipmentId);
+        if (Shipment* s = h ? shipments.get(*h) : nullptr) {
+            // Re-pointing, or reopening a shipment whose item has since been deleted,
+            // needs an item that exists.
+            SlotHandle item = s->Item;
+            if (inventory && (shipment.ItemId != s->ItemId || (!shipment.isDelivered() && !inventory->searchInventory(item)))) {
+                item = inventory->inventoryHandle(shipment.ItemId);
+                if (item == SlotHandle()) return false;
+            }
+            byStatus.update(s->Status.code(), shipment.Status.code(), s->ShipmentId, *h);
+            byOrigin.update(s->Origin.code(), shipment.Origin.code(), s->ShipmentId, *h);
+            byDestination.update(s->Destination.code(), shipment.Destination.code(), s->ShipmentId, *h);
+            if (aggregates) {
+                aggregates->shipment(s->Status.code(), -1);
+                aggregates->shipment(shipment.Status.code(), +1);
+            }
+            untrackDelivery(*s);
+            if (!s->isDelivered()) openByItem.remove(s->ItemId, *h);
+            s->ItemId = shipment.ItemId;
+            s->Item = item;
+            s->Origin = shipment.Origin;
+            s->Destination = shipment.Destination;
+            s->Status = shipment.Status;
+            s->ExpectedDelivery = shipment.ExpectedDelivery;
+            if (!s->isDelivered()) openByItem.add(s->ItemId, s->ShipmentId, *h);
+            trackDelivery(*s);
+            if (versions) versions->put(h->Index, *s);
+            if (journal) journal->log(JournalOp::DispatchShipment, *s);
+            return true;
+        }
+        return false;
+    }
+
+    Shipment* trackShipment(int id) {
+        OperationTimer timer(MetricOp::TrackShipment);
+        const SlotHandle* h = index.find(id);
+        return h ? shipments.get(*h) : nullptr;
+    }
+
+    // Returns nullptr if the shipment behind the handle has been removed.
+    Shipment* trackShipment(SlotHandle h) {
+        return shipments.get(h);
+    }
+
+    SlotHandle shipmentHandle(int id) const {
+        const SlotHandle* h = index.find(id);
+        return h ? *h : SlotHandle();
+    }
+
+    // Keeps a copy-on-write version of the shipments that snapshot() can pin.
+    void enableVersions() {
+        if (versions) return;
+        versions.emplace(shipments.resource());
+        for (size_t i = 0; i < shipments.size(); ++i) {
+            versions->put(shipments.handleAt(i).Index, shipments.view()[i]);
+        }
+    }
+
+    // Consistent view of every shipment as of the last completed change; empty
+    // unless enableVersions was called.
+    VersionedRecords<Shipment>::Snapshot snapshot() const {
+        return versions ? versions->snapshot() : VersionedRecords<Shipment>::Snapshot();
+    }
+
+    // Inserts a record that already carries its ID (snapshot and journal restore).
+    bool restoreShipment(Shipment record) {
+        int id = record.ShipmentId;
+        bool inserted = false;
+        SlotHandle& slot = index.slotFor(id, inserted);
+        if (!inserted) return false;
+        if (inventory && !linksDeferred) record.Item = inventory->inventoryHandle(record.ItemId);
+        trackDelivery(record);
+        slot = shipments.insert(move(record));
+        indexAttributes(*shipments.get(slot), slot);
+        if (id >= nextShipmentId) nextShipmentId = id + 1;
+        return true;
+    }
+
+    // Bulk restore: until linkRestored, restoreShipment leaves the item handle and the
+    // open-shipment link of each record unset. No other change may run in between.
+    void deferLinks() {
+        linksDeferred = true;
+    }
+
+    // Resolves items and links open shipments for everything restored since deferLinks,
+    // in one pass with the item index and link heads prefetched ahead.
+    void linkRestored(size_t prefetchDistance = 8) {
+        if (!linksDeferred) return;
+        linksDeferred = false;
+        if (inventory) openByItem.reserveTargets(inventory->records().size());
+        RecordView<Shipment> view = shipments.view();
+        for (size_t i = 0; i < view.size(); ++i) {
+            if (i + prefetchDistance < view.size()) {
+                int ahead = view[i + prefetchDistance].ItemId;
+                if (inventory) inventory->prefetchId(ahead);
+                openByItem.prefetch(ahead);
+            }
+            SlotHandle h = shipments.handleAt(i);
+            Shipment* s = shipments.get(h);
+            s->Item = inventory ? inventory->inventoryHandle(s->ItemId) : SlotHandle();
+            if (!s->isDelivered()) openByItem.add(s->ItemId, s->ShipmentId, h);
+            if (versions) versions->put(h.Index, *s);
+        }
+    }
+
+    RecordView<Shipment> records() const {
+        return shipments.view();
+    }
+
+    // Records and every index: attributes, open shipments by item, delivery order.
+    size_t memoryBytes() const {
+        size_t bytes = shipments.bytesUsed() + index.bytesUsed() + byStatus.bytesUsed() + byOrigin.bytesUsed() +
+                       byDestination.bytesUsed() + openByItem.bytesUsed() + nodeBytes(deliveries) + nodeBytes(overdueSet);
+        if (versions) bytes += versions->bytesUsed();
+        return bytes;
+    }
+
+    void reserve(size_t n) {
+        shipments.reserve(n);
+        index.reserve(n);
+        byStatus.reserve(n);
+        byOrigin.reserve(n);
+        byDestination.reserve(n);
+        openByItem.reserve(n);
+    }
+
+    void prefetchId(int id) const {
+        index.prefetch(id);
+    }
+
+    int nextId() const {
+        return nextShipmentId;
+    }
+
+    void setNextId(int id) {
+        if (id > nextShipmentId) nextShipmentId = id;
+    }
+
+    RecordView<Shipment> viewShipment() const {
+        return shipments.view();
+    }
+
+    const Shipment* trackShipment(int id) const {
+        OperationTimer timer(MetricOp::TrackShipment);
+        const SlotHandle* h = index.find(id);
+        return h ? shipments.get(*h) : nullptr;
+    }
+
+    // Index join of shipments to items: calls fn with each shipment and its item, or
+    // nullptr if the item is gone or no inventory is attached. Items are reached
+    // through the handle on each shipment, so the pass does no ID lookups.
+    template <typename Fn>
+    size_t joinItems(Fn fn) const {
+        OperationTimer timer(MetricOp::JoinItems);
+        for (const auto& s : shipments) fn(s, inventory ? inventory->searchInventory(s.Item) : nullptr);
+        return shipments.size();
+    }
+
+    // Calls fn for each open shipment of the item, most recently linked first.
+    template <typename Fn>
+    size_t openShipmentsFor(int itemId, Fn fn) const {
+        return openByItem.forEach(itemId, [this, &fn](const ReferenceIndex::Posting& posting) { fn(*shipments.get(posting.Handle)); });
+    }
+
+    // Calls fn, in delivery order, for each shipment expected in [from, to).
+    template <typename Fn>
+    size_t deliveriesBetween(time_t from, time_t to, Fn fn) const {
+        OperationTimer timer(MetricOp::DeliveriesBetween);
+        size_t count = 0;
+        for (auto it = deliveries.lower_bound(make_pair(from, numeric_limits<int>::min()));
+             it != deliveries.end() && it->first < to; ++it) {
+            fn(*shipments.get(shipmentHandle(it->second)));
+            count++;
+        }
+        return count;
+    }
+
+    // Moves undelivered shipments whose deadline is before now into the overdue set.
+    // Only the deadlines crossed since the previous call are visited.
+    size_t advanceClock(time_t now) {
+        OperationTimer timer(MetricOp::AdvanceClock);
+        if (now <= overdueClock) return 0;
+        size_t moved = 0;
+        for (auto it = deliveries.lower_bound(make_pair(overdueClock, numeric_limits<int>::min()));
+             it != deliveries.end() && it->first < now; ++it) {
+            if (!shipments.get(shipmentHandle(it->second))->isDelivered() && overdueSet.insert(*it).second) moved++;
+        }
+        overdueClock = now;
+        return moved;
+    }
+
+    // Calls fn for each late shipment, most overdue first, as of the last advanceClock.
+    template <typename Fn>
+    size_t overdueShipments(Fn fn) const {
+        OperationTimer timer(MetricOp::OverdueShipments);
+        for (const auto& entry : overdueSet) fn(*shipments.get(shipmentHandle(entry.second)));
+        return overdueSet.size();
+    }
+
+    // Calls fn for each shipment matching every given attribute; unset attributes match anything.
+    template <typename Fn>
+    size_t findShipments(const optional<string>& status, const optional<string>& origin,
+                         const optional<string>& destination, Fn fn) const {
+        OperationTimer timer(MetricOp::FindShipments);
+        vector<AttributeFilter<Shipment>> filters;
+        if (!appendFilter(filters, byStatus, &Shipment::Status, status) ||
+            !appendFilter(filters, byOrigin, &Shipment::Origin, origin) ||
+            !appendFilter(filters, byDestination, &Shipment::Destination, destination)) {
+            return 0;
+        }
+        return forEachMatch(shipments, filters, fn);
+    }
+
+    void shipmentSubMenu() {
+        int choice;
+        do {
+            cout << "\n--- Shipment Management ---" << endl;
+            cout << "1. Receive Shipment" << endl;
+            cout << "2. View All Shipments" << endl;
+            cout << "3. Track Shipment" << endl;
+            cout << "4. Dispatch Shipment" << endl;
+            cout << "5. Remove Shipment" << endl;
+            cout << "6. Expire Delivered Shipments" << endl;
+            cout << "7. Find Shipments" << endl;
+            cout << "8. Arriving Today" << endl;
+            cout << "9. Late Shipments" << endl;
+            cout << "0. Back to Main Menu" << endl;
+            cout << "Enter your choice: ";
+            cin >> choice;
+
+            if (cin.fail()) {
+                cerr << "Invalid input. Please enter a number." << endl;
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                choice = -1;
+                continue;
+            }
+
+            switch (choice) {
+                case 1: {
+                    int itemId;
+                    string origin, destination, status;
+                    time_t expectedDelivery = time(nullptr) + (7 * 24 * 3600); // Default to a week from now
+
+                    cout << "Enter Item ID: ";
+                    cin >> itemId;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Enter Origin: ";
+                    getline(cin, origin);
+                    cout << "Enter Destination: ";
+                    getline(cin, destination);
+                    cout << "Enter Status: ";
+                    getline(cin, status);
+                    string date;
+                    cout << "Enter Expected Delivery (YYYY-MM-DD [HH:MM:SS], blank for a week from now): ";
+                    getline(cin, date);
+                    if (!date.empty() && !TimestampFormatter::parse(date, expectedDelivery)) {
+                        cerr << "Invalid date input." << endl;
+                        break;
+                    }
+
+                    Shipment newShipment(0, itemId, origin, destination, status, expectedDelivery);
+                    if (receiveShipment(newShipment)) {
+                        cout << "Shipment received successfully." << endl;
+                    } else {
+                        cout << "Failed to receive shipment: inventory item with ID " << itemId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 2: {
+                    RecordWriter out(cout);
+                    joinItems([&out](const Shipment& s, const Inventory* item) { s.render(out, item); });
+                    break;
+                }
+                case 3: {
+                    int shipmentId;
+                    cout << "Enter Shipment ID to track: ";
+                    cin >> shipmentId;
+                    if (auto shipment = trackShipment(shipmentId)) {
+                        RecordWriter out(cout);
+                        shipment->render(out, inventory ? inventory->searchInventory(shipment->Item) : nullptr);
+                    } else {
+                        cout << "Shipment with ID " << shipmentId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 4: {
+                    int shipmentId, itemId;
+                    string origin, destination, status;
+                    time_t expectedDelivery = time(nullptr) + (7 * 24 * 3600);
+
+                    cout << "Enter Shipment ID to dispatch: ";
+                    cin >> shipmentId;
+                    cout << "Enter Item ID: ";
+                    cin >> itemId;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Enter Origin: ";
+                    getline(cin, origin);
+                    cout << "Enter Destination: ";
+                    getline(cin, destination);
+                    cout << "Enter Status: ";
+                    getline(cin, status);
+                    string date;
+                    cout << "Enter Expected Delivery (YYYY-MM-DD [HH:MM:SS], blank to keep): ";
+                    getline(cin, date);
+                    if (date.empty()) {
+                        if (const Shipment* current = trackShipment(shipmentId)) expectedDelivery = current->ExpectedDelivery;
+                    } else if (!TimestampFormatter::parse(date, expectedDelivery)) {
+                        cerr << "Invalid date input." << endl;
+                        break;
+                    }
+
+                    Shipment updatedShipment(shipmentId, itemId, origin, destination, status, expectedDelivery);
+                    if (dispatchShipment(updatedShipment)) {
+                        cout << "Shipment dispatched successfully." << endl;
+                    } else if (!trackShipment(shipmentId)) {
+                        cout << "Shipment with ID " << shipmentId << " not found." << endl;
+                    } else {
+                        cout << "Failed to dispatch shipment: inventory item with ID " << itemId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 5: {
+                    int shipmentId;
+                    cout << "Enter Shipment ID to remove: ";
+                    cin >> shipmentId;
+                    if (removeShipment(shipmentId)) {
+                        cout << "Shipment removed successfully." << endl;
+                    } else {
+                        cout << "Shipment with ID " << shipmentId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 6:
+                    cout << expireShipments("delivered") << " delivered shipment(s) removed." << endl;
+                    break;
+                case 7: {
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    optional<string> status = readFilter("Status");
+                    optional<string> origin = readFilter("Origin");
+                    optional<string> destination = readFilter("Destination");
+                    size_t found;
+                    {
+                        RecordWriter out(cout);
+                        found = findShipments(status, origin, destination, [&out](const Shipment& s) { s.render(out); });
+                    }
+                    cout << found << " shipment(s) found." << endl;
+                    break;
+                }
+                case 8: {
+                    time_t now = time(nullptr);
+                    tm day;
+#ifdef _MSC_VER
+                    localtime_s(&day, &now);
+#else
+                    localtime_r(&now, &day);
+#endif
+                    day.tm_hour = day.tm_min = day.tm_sec = 0;
+                    day.tm_isdst = -1;
+                    time_t midnight = mktime(&day);
+                    day.tm_mday += 1;
+                    day.tm_isdst = -1;
+                    time_t nextMidnight = mktime(&day);
+                    size_t found;
+                    {
+                        RecordWriter out(cout);
+                        found = deliveriesBetween(midnight, nextMidnight, [&out](const Shipment& s) { s.render(out); });
+                    }
+                    cout << found << " shipment(s) expected today." << endl;
+                    break;
+                }
+                case 9: {
+                    advanceClock(time(nullptr));
+                    size_t found;
+                    {
+                        RecordWriter out(cout);
+                        found = overdueShipments([&out](const Shipment& s) { s.render(out); });
+                    }
+                    cout << found << " late shipment(s)." << endl;
+                    break;
+                }
+                case 0:
+                    cout << "Returning to Main Menu." << endl;
+                    break;
+                default:
+                    cout << "Invalid choice. Please try again." << endl;
+            }
+        } while (choice != 0);
+    }
+};
+
+// --- Space Class ---
+class Space {
+public:
+    int SpaceId;
+    int TotalCapacity;
+    int UsedCapacity;
+    InternedString Zone;
+
+    Space(int spaceId = 0, int totalCapacity = 0, int usedCapacity = 0, InternedString zone = {})
+        : SpaceId(spaceId), TotalCapacity(totalCapacity), UsedCapacity(usedCapacity), Zone(zone) {}
+
+    int getAvailableCapacity() const {
+        return TotalCapacity - UsedCapacity;
+    }
+
+    void render(RecordWriter& out) const {
+        out.beginRecord("space");
+        out.field("Space ID", "SpaceId", SpaceId);
+        out.field("Total Capacity", "TotalCapacity", TotalCapacity);
+        out.field("Used Capacity", "UsedCapacity", UsedCapacity);
+        out.field("Available Capacity", "AvailableCapacity", getAvailableCapacity());
+        out.field("Zone", "Zone", Zone);
+        out.endRecord();
+    }
+
+    void display() const {
+        RecordWriter out(cout);
+        render(out);
+    }
+
+    void writeTo(ByteWriter& out) const {
+        out.putI32(SpaceId);
+        out.putI32(TotalCapacity);
+        out.putI32(UsedCapacity);
+        out.putString(Zone);
+    }
+
+    static Space readFrom(ByteReader& in) {
+        Space sp;
+        sp.SpaceId = in.getI32();
+        sp.TotalCapacity = in.getI32();
+        sp.UsedCapacity = in.getI32();
+        sp.Zone = in.getString();
+        return sp;
+    }
+};
+
+// --- SpaceRepository Class ---
+class SpaceRepository {
+private:
+    SlotMap<Space> spaces;
+    IdIndex index;
+    int nextSpaceId = 1;
+    Journal* journal = nullptr;
+    // (available capacity, SpaceId) for every space, overall and per zone code, so the
+    // best fit for n units is the first entry at or above n.
+    pmr::set<pair<int, int>> byAvailable;
+    pmr::vector<pmr::set<pair<int, int>>> byZoneAvailable;
+    ReportAggregates* aggregates = nullptr;
+
+    void trackCapacity(const Space& sp) {
+        pair<int, int> key(sp.getAvailableCapacity(), sp.SpaceId);
+        byAvailable.insert(key);
+        if (sp.Zone.code() >= byZoneAvailable.size()) byZoneAvailable.resize(sp.Zone.code() + 1);
+        byZoneAvailable[sp.Zone.code()].insert(key);
+        if (aggregates) aggregates->space(sp.Zone.code(), sp.TotalCapacity, sp.UsedCapacity, +1);
+    }
+
+    void untrackCapacity(const Space& sp) {
+        pair<int, int> key(sp.getAvailableCapacity(), sp.SpaceId);
+        byAvailable.erase(key);
+        byZoneAvailable[sp.Zone.code()].erase(key);
+        if (aggregates) aggregates->space(sp.Zone.code(), sp.TotalCapacity, sp.UsedCapacity, -1);
+    }
+
+    // Used capacity outside 0..TotalCapacity would put negative availability into the
+    // capacity sets and break bestFit.
+    static bool validUsage(const Space& sp) {
+        return sp.UsedCapacity >= 0 && sp.UsedCapacity <= sp.TotalCapacity;
+    }
+
+    // Shared by bestFit and reserveCapacity; the caller does the timing.
+    int findFit(int units, const optional<string>& zone) const {
+        const pmr::set<pair<int, int>>* candidates = &byAvailable;
+        if (zone) {
+            uint32_t code;
+            if (!StringDictionary::shared().find(*zone, code) || code >= byZoneAvailable.size()) return 0;
+            candidates = &byZoneAvailable[code];
+        }
+        auto it = candidates->lower_bound(make_pair(units, numeric_limits<int>::min()));
+        return it == candidates->end() ? 0 : it->second;
+    }
+
+    // Shared by updateSpace, reserveCapacity and releaseCapacity; the caller does the timing.
+    bool replaceSpace(const Space& space) {
+        if (!validUsage(space)) return false;
+        if (Space* sp = spaces.get(spaceHandle(space.SpaceId))) {
+            untrackCapacity(*sp);
+            sp->TotalCapacity = space.TotalCapacity;
+            sp->UsedCapacity = space.UsedCapacity;
+            sp->Zone = space.Zone;
+            trackCapacity(*sp);
+            if (journal) journal->log(JournalOp::UpdateSpace, *sp);
+            return true;
+        }
+        return false;
+    }
+
+public:
+    explicit SpaceRepository(pmr::memory_resource* resource = pmr::get_default_resource())
+        : spaces(resource), index(resource), byAvailable(resource), byZoneAvailable(resource) {}
+
+    void attachJournal(Journal* j) {
+        journal = j;
+    }
+
+    // Feeds the report totals; existing spaces are counted immediately.
+    void attachAggregates(ReportAggregates* a) {
+        aggregates = a;
+        if (!aggregates) return;
+        for (const auto& sp : spaces) aggregates->space(sp.Zone.code(), sp.TotalCapacity, sp.UsedCapacity, +1);
+    }
+
+    bool allocateSpace(Space space) {
+        OperationTimer timer(MetricOp::AllocateSpace);
+        if (!validUsage(space)) return false;
+        space.SpaceId = nextSpaceId++;
+        if (journal) journal->log(JournalOp::AllocateSpace, space);
+        trackCapacity(space);
+        index.insert(space.SpaceId, spaces.insert(move(space)));
+        return true;
+    }
+
+    bool freeSpace(int spaceId) {
+        OperationTimer timer(MetricOp::FreeSpace);
+        const SlotHandle* h = index.find(spaceId);
+        if (!h) return false;
+        untrackCapacity(*spaces.get(*h));
+        spaces.erase(*h);
+        index.erase(spaceId);
+        if (journal) journal->logId(JournalOp::FreeSpace, spaceId);
+        return true;
+    }
+
+    bool updateSpace(Space space) {
+        OperationTimer timer(MetricOp::UpdateSpace);
+        return replaceSpace(space);
+    }
+
+    // Adds delta to a space's used capacity without journaling, like
+    // InventoryManager::applyStock.
+    bool applyUsage(int spaceId, long long delta) {
+        Space* sp = spaces.get(spaceHandle(spaceId));
+        if (!sp) return false;
+        untrackCapacity(*sp);
+        sp->UsedCapacity = static_cast<int>(sp->UsedCapacity + delta);
+        trackCapacity(*sp);
+        return true;
+    }
+
+    Space* searchSpace(int id) {
+        OperationTimer timer(MetricOp::SearchSpace);
+        const SlotHandle* h = index.find(id);
+        return h ? spaces.get(*h) : nullptr;
+    }
+
+    const Space* searchSpace(int id) const {
+        OperationTimer timer(MetricOp::SearchSpace);
+        const SlotHandle* h = index.find(id);
+        return h ? spaces.get(*h) : nullptr;
+    }
+
+    // Returns nullptr if the space behind the handle has been freed.
+    Space* searchSpace(SlotHandle h) {
+        return spaces.get(h);
+    }
+
+    SlotHandle spaceHandle(int id) const {
+        const SlotHandle* h = index.find(id);
+        return h ? *h : SlotHandle();
+    }
+
+    // Inserts a record that already carries its ID (snapshot and journal restore).
+    bool restoreSpace(Space record) {
+        int id = record.SpaceId;
+        bool inserted = false;
+        SlotHandle& slot = index.slotFor(id, inserted);
+        if (!inserted) return false;
+        trackCapacity(record);
+        slot = spaces.insert(move(record));
+        if (id >= nextSpaceId) nextSpaceId = id + 1;
+        return true;
+    }
+
+    RecordView<Space> records() const {
+        return spaces.view();
+    }
+
+    // Records, ID index and the capacity sets.
+    size_t memoryBytes() const {
+        size_t bytes = spaces.bytesUsed() + index.bytesUsed() + nodeBytes(byAvailable) +
+                       byZoneAvailable.capacity() * sizeof(pmr::set<pair<int, int>>);
+        for (const auto& zone : byZoneAvailable) bytes += nodeBytes(zone);
+        return bytes;
+    }
+
+    void reserve(size_t n) {
+        spaces.reserve(n);
+        index.reserve(n);
+    }
+
+    void prefetchId(int id) const {
+        index.prefetch(id);
+    }
+
+    int nextId() const {
+        return nextSpaceId;
+    }
+
+    void setNextId(int id) {
+        if (id > nextSpaceId) nextSpaceId = id;
+    }
+
+    RecordView<Space> viewSpaceUsage() const {
+        return spaces.view();
+    }
+
+    // The space with the least available capacity that still fits `units`, optionally
+    // within one zone (ties go to the lowest ID). Returns 0 if nothing fits.
+    int bestFit(int units, const optional<string>& zone = nullopt) const {
+        OperationTimer timer(MetricOp::BestFit);
+        return findFit(units, zone);
+    }
+
+    // Reserves `units` in the best-fitting space and returns its ID, or 0 if nothing fits.
+    int reserveCapacity(int units, const optional<string>& zone = nullopt) {
+        OperationTimer timer(MetricOp::ReserveCapacity);
+        if (units <= 0) return 0;
+        int spaceId = findFit(units, zone);
+        if (spaceId == 0) return 0;
+        Space space = *spaces.get(spaceHandle(spaceId));
+        space.UsedCapacity += units;
+        replaceSpace(space);
+        return spaceId;
+    }
+
+    bool releaseCapacity(int spaceId, int units) {
+        OperationTimer timer(MetricOp::ReleaseCapacity);
+        Space* sp = spaces.get(spaceHandle(spaceId));
+        if (!sp || units <= 0 || units > sp->UsedCapacity) return false;
+        Space space = *sp;
+        space.UsedCapacity -= units;
+        return replaceSpace(space);
+    }
+
+    void spaceSubMenu() {
+        int choice;
+        do {
+            cout << "\n--- Space Management ---" << endl;
+            cout << "1. Allocate Space" << endl;
+            cout << "2. View Space Usage" << endl;
+            cout << "3. Search Space" << endl;
+            cout << "4. Update Space" << endl;
+            cout << "5. Free Space" << endl;
+            cout << "6. Reserve Capacity" << endl;
+            cout << "7. Release Capacity" << endl;
+            cout << "0. Back to Main Menu" << endl;
+            cout << "Enter your choice: ";
+            cin >> choice;
+
+            if (cin.fail()) {
+                cerr << "Invalid input. Please enter a number." << endl;
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                choice = -1;
+                continue;
+            }
+
+            switch (choice) {
+                case 1: {
+                    int totalCapacity, usedCapacity;
+                    string zone;
+                    cout << "Enter Total Capacity: ";
+                    cin >> totalCapacity;
+                    cout << "Enter Used Capacity: ";
+                    cin >> usedCapacity;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Enter Zone: ";
+                    getline(cin, zone);
+                    Space newSpace(0, totalCapacity, usedCapacity, zone);
+                    if (allocateSpace(newSpace)) {
+                        cout << "Space allocated successfully." << endl;
+                    } else {
+                        cout << "Failed to allocate space." << endl;
+                    }
+                    break;
+                }
+                case 2: {
+                    RecordWriter out(cout);
+                    for (const auto& sp : viewSpaceUsage()) {
+                        sp.render(out);
+                    }
+                    break;
+                }
+                case 3: {
+                    int spaceId;
+                    cout << "Enter Space ID to search: ";
+                    cin >> spaceId;
+                    if (auto space = searchSpace(spaceId)) {
+                        space->display();
+                    } else {
+                        cout << "Space with ID " << spaceId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 4: {
+                    int spaceId, totalCapacity, usedCapacity;
+                    string zone;
+                    cout << "Enter Space ID to update: ";
+                    cin >> spaceId;
+                    cout << "Enter new Total Capacity: ";
+                    cin >> totalCapacity;
+                    cout << "Enter new Used Capacity: ";
+                    cin >> usedCapacity;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Enter new Zone: ";
+                    getline(cin, zone);
+                    Space updatedSpace(spaceId, totalCapacity, usedCapacity, zone);
+                    if (updateSpace(updatedSpace)) {
+                        cout << "Space updated successfully." << endl;
+                    } else {
+                        cout << "Failed to update space." << endl;
+                    }
+                    break;
+                }
+                case 5: {
+                    int spaceId;
+                    cout << "Enter Space ID to free: ";
+                    cin >> spaceId;
+                    if (freeSpace(spaceId)) {
+                        cout << "Space freed successfully." << endl;
+                    } else {
+                        cout << "Space with ID " << spaceId << " not found." << endl;
+                    }
+                    break;
+                }
+                case 6: {
+                    int units;
+                    cout << "Enter units to reserve: ";
+                    cin >> units;
+                    if (cin.fail() || units <= 0) {
+                        cerr << "Invalid units input." << endl;
+                        cin.clear();
+                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                        break;
+                    }
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    optional<string> zone = readFilter("Zone");
+                    if (int spaceId = reserveCapacity(units, zone)) {
+                        const Space* sp = searchSpace(spaceId);
+                        cout << "Reserved " << units << " unit(s) in space " << spaceId << " (zone " << sp->Zone << ", "
+                             << sp->getAvailableCapacity() << " left)." << endl;
+                    } else {
+                        cout << "No space has " << units << " unit(s) available." << endl;
+                    }
+                    break;
+                }
+                case 7: {
+                    int spaceId, units;
+                    cout << "Enter Space ID: ";
+                    cin >> spaceId;
+                    cout << "Enter units to release: ";
+                    cin >> units;
+                    if (cin.fail()) {
+                        cerr << "Invalid input." << endl;
+                        cin.clear();
+                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                        break;
+                    }
+                    if (releaseCapacity(spaceId, units)) {
+                        cout << "Released " << units << " unit(s) from space " << spaceId << "." << endl;
+                    } else {
+                        cout << "Cannot release " << units << " unit(s) from space " << spaceId << "." << endl;
+                    }
+                    break;
+                }
+                case 0:
+                    cout << "Returning to Main Menu." << endl;
+                    break;
+                default:
+                    cout << "Invalid choice. Please try again." << endl;
+            }
+        } while (choice != 0);
+    }
+};
+
+// --- WarehouseBatch Class ---
+// Changes to several repositories that Warehouse::applyBatch applies as one unit:
+// shipments to receive, item quantity changes and space usage changes. The batch is
+// also the unit's journal record, so recovery replays all of it or none.
+class WarehouseBatch {
+public:
+    vector<Shipment> Shipments;
+    vector<pair<int, long long>> StockDeltas;
+    vector<pair<int, long long>> SpaceDeltas;
+    time_t Timestamp = 0;
+
+    // Receives `quantity` units of the shipment's item: its stock grows by that much
+    // and, when a space is given, so does that space's used capacity.
+    void receive(Shipment shipment, int quantity = 0, int spaceId = 0) {
+        if (quantity) adjustStock(shipment.ItemId, quantity);
+        if (quantity && spaceId) occupySpace(spaceId, quantity);
+        Shipments.push_back(move(shipment));
+    }
+
+    void adjustStock(int itemId, long long delta) {
+        StockDeltas.emplace_back(itemId, delta);
+    }
+
+    void occupySpace(int spaceId, long long units) {
+        SpaceDeltas.emplace_back(spaceId, units);
+    }
+
+    bool empty() const {
+        return Shipments.empty() && StockDeltas.empty() && SpaceDeltas.empty();
+    }
+
+    // Sums the deltas per item and per space, so each record is updated once however
+    // many lines of the batch touch it.
+    void mergeDeltas() {
+        merge(StockDeltas);
+        merge(SpaceDeltas);
+    }
+
+    void writeTo(ByteWriter& out) const {
+        out.putI64(Timestamp);
+        out.putI32(static_cast<int32_t>(Shipments.size()));
+        for (const auto& s : Shipments) s.writeTo(out);
+        for (const auto* deltas : {&StockDeltas, &SpaceDeltas}) {
+            out.putI32(static_cast<int32_t>(deltas->size()));
+            for (const auto& d : *deltas) {
+                out.putI32(d.first);
+                out.putI64(d.second);
+            }
+        }
+    }
+
+    static WarehouseBatch readFrom(ByteReader& in) {
+        WarehouseBatch batch;
+        batch.Timestamp = static_cast<time_t>(in.getI64());
+        for (int32_t i = 0, n = in.getI32(); i < n && in.ok(); ++i) batch.Shipments.push_back(Shipment::readFrom(in));
+        for (auto* deltas : {&batch.StockDeltas, &batch.SpaceDeltas}) {
+            for (int32_t i = 0, n = in.getI32(); i < n && in.ok(); ++i) {
+                int id = in.getI32();
+                deltas->emplace_back(id, in.getI64());
+            }
+        }
+        return batch;
+    }
+
+private:
+    static void merge(vector<pair<int, long long>>& deltas) {
+        sort(deltas.begin(), deltas.end());
+        size_t kept = 0;
+        for (size_t i = 0; i < deltas.size(); ++i) {
+            if (kept && deltas[kept - 1].first == deltas[i].first) {
+                deltas[kept - 1].second += deltas[i].second;
+            } else {
+                deltas[kept++] = deltas[i];
+            }
+        }
+        deltas.resize(kept);
+    }
+};
+
+// --- Warehouse Class ---
+// The five repositories that make up the application state.
+class Warehouse {
+public:
+    InventoryManager inventoryManager;
+    MaintenanceRepository maintenanceRepo;
+    ReportRepository reportRepo;
+    ShipmentRepository shipmentRepo;
+    SpaceRepository spaceRepo;
+
+    // Every repository allocates its records, their text and indexes from `resource`,
+    // which must outlive the warehouse and any record copied out of it.
+    explicit Warehouse(pmr::memory_resource* resource = pmr::get_default_resource())
+        : inventoryManager(resource), maintenanceRepo(resource), reportRepo(resource), shipmentRepo(resource), spaceRepo(resource) {
+        inventoryManager.attachAggregates(&reportRepo.aggregates());
+        maintenanceRepo.attachAggregates(&reportRepo.aggregates());
+        shipmentRepo.attachAggregates(&reportRepo.aggregates());
+        spaceRepo.attachAggregates(&reportRepo.aggregates());
+        shipmentRepo.attachInventory(&inventoryManager);
+        inventoryManager.attachReferences(&shipmentRepo.itemReferences());
+    }
+
+    // Repositories point at reportRepo's totals and at each other, so a Warehouse
+    // stays where it was built.
+    Warehouse(const Warehouse&) = delete;
+    Warehouse& operator=(const Warehouse&) = delete;
+
+    // Applies every change in the batch or none of them. The batch is checked against
+    // the current state first (items and spaces exist, stock stays non-negative,
+    // spaces do not overflow), then journaled as one record and applied with a single
+    // update per touched item and space. New shipments get consecutive IDs, written
+    // back into the batch; IDs already set must be unused. On failure nothing has changed and `error` says why.
+    bool applyBatch(WarehouseBatch& batch, string& error) {
+        OperationTimer timer(MetricOp::ApplyBatch);
+        batch.mergeDeltas();
+        for (size_t i = 0; i < batch.Shipments.size(); ++i) {
+            int itemId = batch.Shipments[i].ItemId;
+            if (inventoryManager.inventoryHandle(itemId) == SlotHandle()) {
+                error = "shipment " + to_string(i + 1) + " is for unknown item " + to_string(itemId);
+                return false;
+            }
+        }
+        for (const auto& d : batch.StockDeltas) {
+            const Inventory* item = inventoryManager.searchInventory(inventoryManager.inventoryHandle(d.first));
+            if (!item) {
+                error = "unknown item " + to_string(d.first);
+                return false;
+            }
+            long long quantity = item->Quantity + d.second;
+            if (quantity < 0 || quantity > numeric_limits<int>::max()) {
+                error = "item " + to_string(d.first) + " would hold " + to_string(quantity) + " units";
+                return false;
+            }
+        }
+        for (const auto& d : batch.SpaceDeltas) {
+            const Space* sp = spaceRepo.searchSpace(spaceRepo.spaceHandle(d.first));
+            if (!sp) {
+                error = "unknown space " + to_string(d.first);
+                return false;
+            }
+            long long used = sp->UsedCapacity + d.second;
+            if (used < 0 || used > sp->TotalCapacity) {
+                error = "space " + to_string(d.first) + " would use " + to_string(used) + " of " + to_string(sp->TotalCapacity) + " units";
+                return false;
+            }
+        }
+
+        // A replayed batch already carries its IDs and timestamp. Preset IDs must be
+        // new and distinct from each other and from the ones assigned here.
+        int nextShipmentId = shipmentRepo.nextId();
+        vector<int> ids;
+        ids.reserve(batch.Shipments.size());
+        for (const auto& s : batch.Shipments) {
+            if (s.ShipmentId < 0 || (s.ShipmentId && shipmentRepo.shipmentHandle(s.ShipmentId) != SlotHandle())) {
+                error = "shipment ID " + to_string(s.ShipmentId) + " is already taken";
+                return false;
+            }
+            ids.push_back(s.ShipmentId ? s.ShipmentId : nextShipmentId++);
+        }
+        vector<int> sorted = ids;
+        sort(sorted.begin(), sorted.end());
+        auto repeated = adjacent_find(sorted.begin(), sorted.end());
+        if (repeated != sorted.end()) {
+            error = "shipment ID " + to_string(*repeated) + " appears twice";
+            return false;
+        }
+        for (size_t i = 0; i < ids.size(); ++i) batch.Shipments[i].ShipmentId = ids[i];
+        if (!batch.Timestamp) batch.Timestamp = time(nullptr);
+        if (journal) journal->log(JournalOp::ApplyBatch, batch);
+
+        shipmentRepo.reserve(shipmentRepo.records().size() + batch.Shipments.size());
+        for (const auto& s : batch.Shipments) {
+            bool restored = shipmentRepo.restoreShipment(s);
+            assert(restored && "shipment IDs were checked above");
+            (void)restored;
+        }
+        for (const auto& d : batch.StockDeltas) inventoryManager.applyStock(d.first, d.second, batch.Timestamp);
+        for (const auto& d : batch.SpaceDeltas) spaceRepo.applyUsage(d.first, d.second);
+        return true;
+    }
+
+    void attachJournal(Journal* j) {
+        journal = j;
+        inventoryManager.attachJournal(journal);
+        maintenanceRepo.attachJournal(journal);
+        reportRepo.attachJournal(journal);
+        shipmentRepo.attachJournal(journal);
+        spaceRepo.attachJournal(journal);
+    }
+
+private:
+    Journal* journal = nullptr;
+};
+
+// --- Metrics Report ---
+// Writes operation counters, sampled latency histograms, record counts and storage
+// bytes in the Prometheus text exposition format.
+void writeMetrics(ostream& out, const Warehouse& warehouse) {
+    Metrics::Totals totals = Metrics::shared().totals();
+    out << "# HELP logistics_operations_total Repository operations performed.\n";
+    out << "# TYPE logistics_operations_total counter\n";
+    for (size_t i = 0; i < Metrics::OpCount; ++i) {
+        out << "logistics_operations_total{op=\"" << Metrics::name(static_cast<MetricOp>(i)) << "\"} " << totals.Calls[i] << '\n';
+    }
+    out << "# HELP logistics_operation_duration_seconds Latency of sampled repository operations.\n";
+    out << "# TYPE logistics_operation_duration_seconds histogram\n";
+    char bound[32];
+    for (size_t i = 0; i < Metrics::OpCount; ++i) {
+        if (totals.Samples[i] == 0) continue;
+        const char* op = Metrics::name(static_cast<MetricOp>(i));
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b + 1 < Metrics::Buckets; ++b) {
+            cumulative += totals.Histogram[i][b];
+            snprintf(bound, sizeof(bound), "%g", static_cast<double>(1ull << b) / 1e9);
+            out << "logistics_operation_duration_seconds_bucket{op=\"" << op << "\",le=\"" << bound << "\"} " << cumulative << '\n';
+        }
+        out << "logistics_operation_duration_seconds_bucket{op=\"" << op << "\",le=\"+Inf\"} " << totals.Samples[i] << '\n';
+        snprintf(bound, sizeof(bound), "%.9f", static_cast<double>(totals.SampledNanos[i]) / 1e9);
+        out << "logistics_operation_duration_seconds_sum{op=\"" << op << "\"} " << bound << '\n';
+        out << "logistics_operation_duration_seconds_count{op=\"" << op << "\"} " << totals.Samples[i] << '\n';
+    }
+    const pair<const char*, pair<size_t, size_t>> repositories[] = {
+        {"inventory", {warehouse.inventoryManager.records().size(), warehouse.inventoryManager.memoryBytes()}},
+        {"maintenance", {warehouse.maintenanceRepo.records().size(), warehouse.maintenanceRepo.memoryBytes()}},
+        {"reports", {warehouse.reportRepo.records().size(), warehouse.reportRepo.memoryBytes()}},
+        {"shipments", {warehouse.shipmentRepo.records().size(), warehouse.shipmentRepo.memoryBytes()}},
+        {"spaces", {warehouse.spaceRepo.records().size(), warehouse.spaceRepo.memoryBytes()}}};
+    out << "# HELP logistics_records Records held by each repository.\n";
+    out << "# TYPE logistics_records gauge\n";
+    for (const auto& r : repositories) out << "logistics_records{repository=\"" << r.first << "\"} " << r.second.first << '\n';
+    out << "# HELP logistics_storage_bytes Bytes held by each repository's records, indexes and text.\n";
+    out << "# TYPE logistics_storage_bytes gauge\n";
+    for (const auto& r : repositories) out << "logistics_storage_bytes{repository=\"" << r.first << "\"} " << r.second.second << '\n';
+    out << "# HELP logistics_interned_strings Distinct strings in the shared dictionary.\n";
+    out << "# TYPE logistics_interned_strings gauge\n";
+    out << "logistics_interned_strings " << StringDictionary::shared().size() << '\n';
+    out << "# HELP logistics_name_index_words Distinct words in the item name search index (0 until the first name search).\n";
+    out << "# TYPE logistics_name_index_words gauge\n";
+    out << "logistics_name_index_words " << warehouse.inventoryManager.nameVocabulary() << '\n';
+}
+
+// Prints a per-operation summary and optionally saves the exposition text to a file.
+void showMetrics(const Warehouse& warehouse) {
+    Metrics::Totals totals = Metrics::shared().totals();
+    cout << "\n--- Metrics ---" << endl;
+    cout << left << setw(22) << "Operation" << right << setw(12) << "Calls" << setw(12) << "Mean ns" << setw(12) << "p50 ns"
+         << setw(12) << "p99 ns" << endl;
+    for (size_t i = 0; i < Metrics::OpCount; ++i) {
+        if (totals.Calls[i] == 0) continue;
+        MetricOp op = static_cast<MetricOp>(i);
+        cout << left << setw(22) << Metrics::name(op) << right << setw(12) << totals.Calls[i];
+        if (totals.Samples[i]) {
+            cout << setw(12) << totals.SampledNanos[i] / totals.Samples[i] << setw(12) << "<" + to_string(totals.quantile(op, 0.5))
+                 << setw(12) << "<" + to_string(totals.quantile(op, 0.99));
+        }
+        cout << endl;
+    }
+    cout << "Records: " << warehouse.inventoryManager.records().size() << " items, " << warehouse.shipmentRepo.records().size()
+         << " shipments, " << warehouse.spaceRepo.records().size() << " spaces, " << warehouse.maintenanceRepo.records().size()
+         << " schedules, " << warehouse.reportRepo.records().size() << " reports" << endl;
+
+    string path;
+    cout << "Save Prometheus text to file (blank to skip): ";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    getline(cin, path);
+    if (path.empty()) return;
+    ofstream file(path);
+    writeMetrics(file, warehouse);
+    if (file) {
+        cout << "Metrics written to " << path << "." << endl;
+    } else {
+        cerr << "Cannot write " << path << endl;
+    }
+}
+
+// --- MappedFile Class ---
+// Read-only view of a whole file: mmap on POSIX, a plain read elsewhere.
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const string& path) {
+        close();
+#ifdef _WIN32
+        ifstream in(path, ios::binary | ios::ate);
+        if (!in) return false;
+        buffer.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(buffer.data(), static_cast<streamsize>(buffer.size()));
+        if (!in) return false;
+        bytes = buffer.data();
+        length = buffer.size();
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            bytes = static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+        return true;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        buffer.clear();
+#else
+        if (bytes) munmap(const_cast<char*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+};
+
+// --- SnapshotStore Class ---
+// Versioned binary snapshot of the whole warehouse. Layout:
+//   header | inventory | maintenance | report | shipment | space | string heap
+// Each section is an array of fixed-width records; text fields are (offset, length)
+// references into the shared string heap, where repeated values are stored once.
+// Version 2 adds the epoch of the newest journal folded into the snapshot.
+class SnapshotStore {
+public:
+    static constexpr uint32_t Version = 2;
+
+private:
+    enum SectionKind : uint32_t { InventorySection, MaintenanceSection, ReportSection, ShipmentSection, SpaceSection, NumSections };
+
+    struct StringRef {
+        uint64_t Offset;
+        uint32_t Length;
+        uint32_t Reserved;
+    };
+
+    struct SectionEntry {
+        uint32_t Kind;
+        uint32_t RecordSize;
+        uint64_t Offset;
+        uint64_t Count;
+        int64_t NextId;
+    };
+
+    struct Header {
+        char Magic[8];
+        uint32_t Version;
+        uint32_t SectionCount;
+        uint64_t HeapOffset;
+        uint64_t HeapSize;
+        SectionEntry Sections[NumSections];
+        uint64_t JournalEpoch;
+    };
+
+    static constexpr size_t HeaderSizeV1 = offsetof(Header, JournalEpoch);
+
+    struct InventoryRecord {
+        int32_t ItemId;
+        int32_t Quantity;
+        int64_t LastUpdated;
+        StringRef ItemName, Category, Location;
+    };
+
+    struct MaintenanceRecord {
+        int32_t ScheduleId;
+        int32_t EquipmentId;
+        int64_t ScheduledDate;
+        StringRef Description, CompletionStatus;
+    };
+
+    struct ReportRecord {
+        int32_t ReportId;
+        int32_t Reserved;
+        int64_t GeneratedOn;
+        StringRef ReportType, Details;
+    };
+
+    struct ShipmentRecord {
+        int32_t ShipmentId;
+        int32_t ItemId;
+        int64_t ExpectedDelivery;
+        StringRef Origin, Destination, Status;
+    };
+
+    struct SpaceRecord {
+        int32_t SpaceId;
+        int32_t TotalCapacity;
+        int32_t UsedCapacity;
+        int32_t Reserved;
+        StringRef Zone;
+    };
+
+    static constexpr char MagicBytes[8] = {'L', 'G', 'S', 'N', 'A', 'P', '\0', '\0'};
+    static constexpr uint64_t PrefetchDistance = 8;
+
+    // Accumulates the string heap. Short values are stored once; the dedup table is
+    // capped so unique text (item names, details) does not grow it without bound.
+    class HeapBuilder {
+    private:
+        static constexpr size_t MaxDedupLength = 32;
+        static constexpr size_t MaxDedupEntries = 1 << 16;
+
+        string heap;
+        unordered_map<string, uint64_t> offsets;
+        vector<StringRef> interned;
+
+    public:
+        StringRef add(const string& value) {
+            uint64_t offset = heap.size();
+            if (value.size() <= MaxDedupLength) {
+                auto it = offsets.find(value);
+                if (it != offsets.end()) {
+                    return StringRef{it->second, static_cast<uint32_t>(value.size()), 0};
+                }
+                if (offsets.size() < MaxDedupEntries) offsets.emplace(value, offset);
+            }
+            heap += value;
+            return StringRef{offset, static_cast<uint32_t>(value.size()), 0};
+        }
+
+        StringRef add(string_view value) {
+            if (value.size() <= MaxDedupLength) return add(string(value));
+            uint64_t offset = heap.size();
+            heap.append(value.data(), value.size());
+            return StringRef{offset, static_cast<uint32_t>(value.size()), 0};
+        }
+
+        // Dictionary-encoded values are written once per code.
+        StringRef add(InternedString value) {
+            uint32_t code = value.code();
+            if (code >= interned.size()) interned.resize(code + 1, StringRef{0, UINT32_MAX, 0});
+            if (interned[code].Length == UINT32_MAX) interned[code] = add(value.str());
+            return interned[code];
+        }
+
+        const string& bytes() const {
+            return heap;
+        }
+    };
+
+    template <typename Record, typename T, typename Encode>
+    static bool writeSection(FILE* out, SectionEntry& entry, uint32_t kind, RecordView<T> values, int nextId, Encode encode) {
+        entry.Kind = kind;
+        entry.RecordSize = sizeof(Record);
+        entry.Offset = static_cast<uint64_t>(ftell(out));
+        entry.Count = values.size();
+        entry.NextId = nextId;
+        vector<Record> batch;
+        batch.reserve(4096);
+        for (const auto& value : values) {
+            batch.push_back(encode(value));
+            if (batch.size() == 4096) {
+                if (fwrite(batch.data(), sizeof(Record), batch.size(), out) != batch.size()) return false;
+                batch.clear();
+            }
+        }
+        return batch.empty() || fwrite(batch.data(), sizeof(Record), batch.size(), out) == batch.size();
+    }
+
+    template <typename Record>
+    static const Record* sectionRecords(const MappedFile& file, const SectionEntry& entry) {
+        if (entry.RecordSize != sizeof(Record)) return nullptr;
+        if (entry.Offset > file.size() || entry.Count > (file.size() - entry.Offset) / sizeof(Record)) return nullptr;
+        return reinterpret_cast<const Record*>(file.data() + entry.Offset);
+    }
+
+public:
+    static bool save(const Warehouse& warehouse, const string& path, uint64_t journalEpoch = 0) {
+        string tmpPath = path + ".tmp";
+        FILE* out = fopen(tmpPath.c_str(), "wb");
+        if (!out) {
+            cerr << "Cannot write snapshot " << tmpPath << endl;
+            return false;
+        }
+        setvbuf(out, nullptr, _IOFBF, 1 << 20);
+
+        Header header{};
+        memcpy(header.Magic, MagicBytes, sizeof(MagicBytes));
+        header.Version = Version;
+        header.SectionCount = NumSections;
+        header.JournalEpoch = journalEpoch;
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+        HeapBuilder heap;
+        ok = ok && writeSection<InventoryRecord>(out, header.Sections[InventorySection], InventorySection,
+            warehouse.inventoryManager.records(), warehouse.inventoryManager.nextId(), [&heap](const Inventory& v) {
+                return InventoryRecord{v.ItemId, v.Quantity, static_cast<int64_t>(v.LastUpdated),
+                                       heap.add(v.ItemName), heap.add(v.Category), heap.add(v.Location)};
+            });
+        ok = ok && writeSection<MaintenanceRecord>(out, header.Sections[MaintenanceSection], MaintenanceSection,
+            warehouse.maintenanceRepo.records(), warehouse.maintenanceRepo.nextId(), [&heap](const Maintenance& v) {
+                return MaintenanceRecord{v.ScheduleId, v.EquipmentId, static_cast<int64_t>(v.ScheduledDate),
+                                         heap.add(v.Description), heap.add(v.CompletionStatus)};
+            });
+        ok = ok && writeSection<ReportRecord>(out, header.Sections[ReportSection], ReportSection,
+            warehouse.reportRepo.records(), warehouse.reportRepo.nextId(), [&heap](const Report& v) {
+                return ReportRecord{v.ReportId, 0, static_cast<int64_t>(v.GeneratedOn), heap.add(v.ReportType), heap.add(v.Details)};
+            });
+        ok = ok && writeSection<ShipmentRecord>(out, header.Sections[ShipmentSection], ShipmentSection,
+            warehouse.shipmentRepo.records(), warehouse.shipmentRepo.nextId(), [&heap](const Shipment& v) {
+                return ShipmentRecord{v.ShipmentId, v.ItemId, static_cast<int64_t>(v.ExpectedDelivery),
+                                      heap.add(v.Origin), heap.add(v.Destination), heap.add(v.Status)};
+            });
+        ok = ok && writeSection<SpaceRecord>(out, header.Sections[SpaceSection], SpaceSection,
+            warehouse.spaceRepo.records(), warehouse.spaceRepo.nextId(), [&heap](const Space& v) {
+                return SpaceRecord{v.SpaceId, v.TotalCapacity, v.UsedCapacity, 0, heap.add(v.Zone)};
+            });
+
+        header.HeapOffset = static_cast<uint64_t>(ftell(out));
+        header.HeapSize = heap.bytes().size();
+        ok = ok && fwrite(heap.bytes().data(), 1, heap.bytes().size(), out) == heap.bytes().size();
+        ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+        ok = ok && fflush(out) == 0;
+#ifndef _WIN32
+        ok = ok && fsync(fileno(out)) == 0;
+#endif
+        ok = (fclose(out) == 0) && ok;
+#ifdef _WIN32
+        if (ok) remove(path.c_str());
+#endif
+        ok = ok && rename(tmpPath.c_str(), path.c_str()) == 0;
+        if (!ok) {
+            cerr << "Failed to write snapshot " << path << endl;
+            remove(tmpPath.c_str());
+        }
+        return ok;
+    }
+
+    // Restores every section into the (normally empty) warehouse.
+    static bool load(Warehouse& warehouse, const string& path, uint64_t* journalEpoch = nullptr) {
+        MappedFile file;
+        if (!file.open(path)) {
+            cerr << "Cannot open snapshot " << path << endl;
+            return false;
+        }
+        if (file.size() < HeaderSizeV1) {
+            cerr << "Snapshot " << path << " is truncated." << endl;
+            return false;
+        }
+        Header header{};
+        memcpy(&header, file.data(), HeaderSizeV1);
+        if (memcmp(header.Magic, MagicBytes, sizeof(MagicBytes)) != 0 || header.SectionCount != NumSections) {
+            cerr << "Snapshot " << path << " is not a warehouse snapshot." << endl;
+            return false;
+        }
+        if (header.Version == 0 || header.Version > Version) {
+            cerr << "Snapshot " << path << " has unsupported version " << header.Version << "." << endl;
+            return false;
+        }
+        if (header.Version >= 2) {
+            if (file.size() < sizeof(Header)) {
+                cerr << "Snapshot " << path << " is truncated." << endl;
+                return false;
+            }
+            memcpy(&header, file.data(), sizeof(header));
+        }
+        if (journalEpoch) *journalEpoch = header.JournalEpoch;
+        if (header.HeapOffset > file.size() || header.HeapSize > file.size() - header.HeapOffset) {
+            cerr << "Snapshot " << path << " is truncated." << endl;
+            return false;
+        }
+        const char* heap = file.data() + header.HeapOffset;
+        bool corrupt = false;
+        auto text = [heap, &header, &corrupt](const StringRef& ref) {
+            if (ref.Offset > header.HeapSize || ref.Length > header.HeapSize - ref.Offset) {
+                corrupt = true;
+                return string();
+            }
+            return string(heap + ref.Offset, ref.Length);
+        };
+        // Free-form text goes straight into the repository's resource.
+        auto heapText = [heap, &header, &corrupt](const StringRef& ref, pmr::memory_resource* resource) {
+            if (ref.Offset > header.HeapSize || ref.Length > header.HeapSize - ref.Offset) {
+                corrupt = true;
+                return HeapString();
+            }
+            return HeapString(string_view(heap + ref.Offset, ref.Length), resource);
+        };
+        auto interned = [heap, &header, &corrupt](const StringRef& ref) {
+            if (ref.Offset > header.HeapSize || ref.Length > header.HeapSize - ref.Offset) {
+                corrupt = true;
+                return InternedString();
+            }
+            return InternedString(string_view(heap + ref.Offset, ref.Length));
+        };
+
+        const SectionEntry* sections = header.Sections;
+        auto inventory = sectionRecords<InventoryRecord>(file, sections[InventorySection]);
+        auto maintenance = sectionRecords<MaintenanceRecord>(file, sections[MaintenanceSection]);
+        auto reports = sectionRecords<ReportRecord>(file, sections[ReportSection]);
+        auto shipments = sectionRecords<ShipmentRecord>(file, sections[ShipmentSection]);
+        auto spaces = sectionRecords<SpaceRecord>(file, sections[SpaceSection]);
+        if (!inventory || !maintenance || !reports || !shipments || !spaces) {
+            cerr << "Snapshot " << path << " has a damaged section table." << endl;
+            return false;
+        }
+
+        InventoryManager& inventoryManager = warehouse.inventoryManager;
+        inventoryManager.reserve(sections[InventorySection].Count);
+        for (uint64_t i = 0; i < sections[InventorySection].Count; ++i) {
+            if (i + PrefetchDistance < sections[InventorySection].Count) inventoryManager.prefetchId(inventory[i + PrefetchDistance].ItemId);
+            const InventoryRecord& r = inventory[i];
+            Inventory item(r.ItemId, heapText(r.ItemName, inventoryManager.resource()), interned(r.Category), r.Quantity, interned(r.Location));
+            item.LastUpdated = static_cast<time_t>(r.LastUpdated);
+            inventoryManager.restoreInventory(move(item));
+        }
+        inventoryManager.setNextId(static_cast<int>(sections[InventorySection].NextId));
+
+        MaintenanceRepository& maintenanceRepo = warehouse.maintenanceRepo;
+        maintenanceRepo.reserve(sections[MaintenanceSection].Count);
+        for (uint64_t i = 0; i < sections[MaintenanceSection].Count; ++i) {
+            if (i + PrefetchDistance < sections[MaintenanceSection].Count) maintenanceRepo.prefetchId(maintenance[i + PrefetchDistance].ScheduleId);
+            const MaintenanceRecord& r = maintenance[i];
+            maintenanceRepo.restoreMaintenance(Maintenance(r.ScheduleId, r.EquipmentId, heapText(r.Description, maintenanceRepo.resource()),
+                                                           static_cast<time_t>(r.ScheduledDate), interned(r.CompletionStatus)));
+        }
+        maintenanceRepo.setNextId(static_cast<int>(sections[MaintenanceSection].NextId));
+
+        ReportRepository& reportRepo = warehouse.reportRepo;
+        reportRepo.reserve(sections[ReportSection].Count);
+        for (uint64_t i = 0; i < sections[ReportSection].Count; ++i) {
+            if (i + PrefetchDistance < sections[ReportSection].Count) reportRepo.prefetchId(reports[i + PrefetchDistance].ReportId);
+            const ReportRecord& r = reports[i];
+            reportRepo.restoreReport(Report(r.ReportId, text(r.ReportType), static_cast<time_t>(r.GeneratedOn), text(r.Details)));
+        }
+        reportRepo.setNextId(static_cast<int>(sections[ReportSection].NextId));
+
+        ShipmentRepository& shipmentRepo = warehouse.shipmentRepo;
+        shipmentRepo.reserve(sections[ShipmentSection].Count);
+        shipmentRepo.deferLinks();
+        for (uint64_t i = 0; i < sections[ShipmentSection].Count; ++i) {
+            if (i + PrefetchDistance < sections[ShipmentSection].Count) shipmentRepo.prefetchId(shipments[i + PrefetchDistance].ShipmentId);
+            const ShipmentRecord& r = shipments[i];
+            shipmentRepo.restoreShipment(Shipment(r.ShipmentId, r.ItemId, interned(r.Origin), interned(r.Destination),
+                                                  interned(r.Status), static_cast<time_t>(r.ExpectedDelivery)));
+        }
+        shipmentRepo.linkRestored(PrefetchDistance);
+        shipmentRepo.setNextId(static_cast<int>(sections[ShipmentSection].NextId));
+
+        SpaceRepository& spaceRepo = warehouse.spaceRepo;
+        spaceRepo.reserve(sections[SpaceSection].Count);
+        for (uint64_t i = 0; i < sections[SpaceSection].Count; ++i) {
+            if (i + PrefetchDistance < sections[SpaceSection].Count) spaceRepo.prefetchId(spaces[i + PrefetchDistance].SpaceId);
+            const SpaceRecord& r = spaces[i];
+            spaceRepo.restoreSpace(Space(r.SpaceId, r.TotalCapacity, r.UsedCapacity, interned(r.Zone)));
+        }
+        spaceRepo.setNextId(static_cast<int>(sections[SpaceSection].NextId));
+
+        if (corrupt) {
+            cerr << "Snapshot " << path << " references text outside its string heap." << endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+// --- JournalReplay Class ---
+// Re-applies journal records on top of a restored snapshot.
+class JournalReplay {
+private:
+    static bool apply(Warehouse& warehouse, JournalOp op, ByteReader& in) {
+        switch (op) {
+            case JournalOp::AddInventory:
+                warehouse.inventoryManager.restoreInventory(Inventory::readFrom(in));
+                break;
+            case JournalOp::EditInventory:
+                warehouse.inventoryManager.editInventory(Inventory::readFrom(in));
+                break;
+            case JournalOp::DeleteInventory:
+                warehouse.inventoryManager.deleteInventory(in.getI32());
+                break;
+            case JournalOp::ScheduleMaintenance:
+                warehouse.maintenanceRepo.restoreMaintenance(Maintenance::readFrom(in));
+                break;
+            case JournalOp::UpdateSchedule:
+                warehouse.maintenanceRepo.updateSchedule(Maintenance::readFrom(in));
+                break;
+            case JournalOp::RemoveMaintenance:
+                warehouse.maintenanceRepo.removeMaintenance(in.getI32());
+                break;
+            case JournalOp::GenerateReport:
+                warehouse.reportRepo.restoreReport(Report::readFrom(in));
+                break;
+            case JournalOp::ReceiveShipment:
+                warehouse.shipmentRepo.restoreShipment(Shipment::readFrom(in));
+                break;
+            case JournalOp::DispatchShipment:
+                warehouse.shipmentRepo.dispatchShipment(Shipment::readFrom(in));
+                break;
+            case JournalOp::RemoveShipment:
+                warehouse.shipmentRepo.removeShipment(in.getI32());
+                break;
+            case JournalOp::ExpireShipments:
+                warehouse.shipmentRepo.expireShipments(in.getString());
+                break;
+            case JournalOp::AllocateSpace:
+                warehouse.spaceRepo.restoreSpace(Space::readFrom(in));
+                break;
+            case JournalOp::UpdateSpace:
+                warehouse.spaceRepo.updateSpace(Space::readFrom(in));
+                break;
+            case JournalOp::FreeSpace:
+                warehouse.spaceRepo.freeSpace(in.getI32());
+                break;
+            case JournalOp::ApplyBatch: {
+                WarehouseBatch batch = WarehouseBatch::readFrom(in);
+                string error;
+                if (in.ok()) warehouse.applyBatch(batch, error);
+                break;
+            }
+            default:
+                return false;
+        }
+        return in.ok();
+    }
+
+public:
+    // Applies the journal at path if its epoch is newer than afterEpoch. Replay stops
+    // at the first torn or corrupt record, which marks the end of what was committed.
+    // Returns false if the file is not a journal.
+    static bool replay(Warehouse& warehouse, const string& path, uint64_t afterEpoch, uint64_t& epoch, size_t& applied) {
+        Metrics::Mute mute;
+        MappedFile file;
+        if (!file.open(path)) {
+            cerr << "Cannot open journal " << path << endl;
+            return false;
+        }
+        if (file.size() < Journal::HeaderSize || memcmp(file.data(), Journal::MagicBytes, sizeof(Journal::MagicBytes)) != 0) {
+            cerr << path << " is not a warehouse journal." << endl;
+            return false;
+        }
+        memcpy(&epoch, file.data() + 16, sizeof(epoch));
+        if (epoch <= afterEpoch) return true;
+
+        size_t offset = Journal::HeaderSize;
+        while (file.size() - offset >= 2 * sizeof(uint32_t)) {
+            uint32_t length, checksum;
+            memcpy(&length, file.data() + offset, sizeof(length));
+            memcpy(&checksum, file.data() + offset + sizeof(length), sizeof(checksum));
+            const char* payload = file.data() + offset + 2 * sizeof(uint32_t);
+            if (length == 0 || length > file.size() - offset - 2 * sizeof(uint32_t) || crc32(payload, length) != checksum) {
+                cerr << "Journal " << path << " ends in a torn record at offset " << offset << "; ignoring the tail." << endl;
+                break;
+            }
+            ByteReader in(payload + 1, length - 1);
+            if (!apply(warehouse, static_cast<JournalOp>(payload[0]), in)) {
+                cerr << "Journal " << path << " has an undecodable record at offset " << offset << "." << endl;
+                break;
+            }
+            applied++;
+            offset += 2 * sizeof(uint32_t) + length;
+        }
+        return true;
+    }
+};
+
+// --- JournalCompactor Class ---
+// Background thread that folds the journal into a new snapshot once it grows past a
+// threshold. The journal is sealed and writers move on to a fresh file; the sealed
+// file is then replayed over the previous snapshot in a private Warehouse, so the
+// live repositories are never locked or copied.
+class JournalCompactor {
+private:
+    Journal& journal;
+    string snapshotPath;
+    uint64_t thresholdBytes;
+    mutex mtx;
+    condition_variable cv;
+    bool stopping = false;
+    thread worker;
+
+    void run() {
+        unique_lock<mutex> lock(mtx);
+        while (!stopping) {
+            cv.wait_for(lock, chrono::seconds(1));
+            if (stopping || journal.size() < thresholdBytes) continue;
+            lock.unlock();
+            compact();
+            lock.lock();
+        }
+    }
+
+public:
+    JournalCompactor(Journal& j, string snapshot, uint64_t threshold)
+        : journal(j), snapshotPath(move(snapshot)), thresholdBytes(threshold) {}
+
+    ~JournalCompactor() {
+        stop();
+    }
+
+    static string sealedPath(const string& journalPath) {
+        return journalPath + ".compacting";
+    }
+
+    void start() {
+        worker = thread(&JournalCompactor::run, this);
+    }
+
+    void stop() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    bool compact() {
+        string sealed = sealedPath(journal.filePath());
+        if (!ifstream(sealed).good() && !journal.rotate(sealed)) return false;
+
+        // The folded copy lives only for this pass, so it allocates from an arena that is
+        // released in one step instead of freeing every record and index on its own.
+        pmr::monotonic_buffer_resource arena;
+        Warehouse folded(&arena);
+        uint64_t snapshotEpoch = 0;
+        if (ifstream(snapshotPath).good() && !SnapshotStore::load(folded, snapshotPath, &snapshotEpoch)) return false;
+        uint64_t sealedEpoch = snapshotEpoch;
+        size_t applied = 0;
+        if (!JournalReplay::replay(folded, sealed, snapshotEpoch, sealedEpoch, applied)) return false;
+        if (!SnapshotStore::save(folded, snapshotPath, sealedEpoch)) return false;
+        remove(sealed.c_str());
+        return true;
+    }
+};
+
+// --- BulkImporter Class ---
+// Non-interactive CSV / JSON Lines import. The file is memory-mapped, split into
+// line-aligned chunks that are parsed on separate threads straight from the mapping,
+// and the validated records are then inserted in file order. Rows that fail to parse
+// or validate are written to the reject file with their line number and reason.
+// A manifest is the exception: its lines are received as one WarehouseBatch, so one
+// bad line rejects the whole file.
+class BulkImporter {
+public:
+    enum class Kind { Inventory, Shipments, Spaces, Manifest };
+    enum class Format { Csv, JsonLines };
+
+    struct Result {
+        size_t Imported = 0;
+        size_t Rejected = 0;
+        double Seconds = 0;
+    };
+
+private:
+    static constexpr size_t MaxFields = 8;
+    static constexpr size_t CommitBatch = 65536;
+
+    struct Fields {
+        array<string_view, MaxFields> Values;
+        array<bool, MaxFields> Present{};
+    };
+
+    struct Reject {
+        size_t Line;
+        string Reason;
+        string_view Text;
+    };
+
+    // One line of a truck manifest: a delivered shipment, the units it brings and the
+    // space they go into (0 for none).
+    struct ManifestLine {
+        Shipment Delivery;
+        int Quantity = 0;
+        int SpaceId = 0;
+    };
+
+    template <typename T>
+    struct ChunkResult {
+        vector<T> Records;
+        vector<Reject> Rejects;
+        size_t Lines = 0;
+    };
+
+    static const vector<string>& fieldNames(Kind kind) {
+        static const vector<string> inventory = {"ItemName", "Category", "Quantity", "Location"};
+        static const vector<string> shipments = {"ItemId", "Origin", "Destination", "Status", "ExpectedDelivery"};
+        static const vector<string> spaces = {"TotalCapacity", "UsedCapacity", "Zone"};
+        static const vector<string> manifest = {"ItemId", "Quantity", "SpaceId", "Origin", "Destination", "Status", "ExpectedDelivery"};
+        switch (kind) {
+            case Kind::Inventory:
+                return inventory;
+            case Kind::Shipments:
+                return shipments;
+            case Kind::Spaces:
+                return spaces;
+            default:
+                return manifest;
+        }
+    }
 
-                    cout << "Enter Equipment ID: ";
-                    cin >> equipmentId;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    cout << "Enter Description: ";
-                    getline(cin, description);
-                    cout << "Enter Completion Status: ";
-                    getline(cin, completionStatus);
+    static bool sameName(string_view a, const string& b) {
+        return a.size() == b.size() && equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return tolower(static_cast<unsigned char>(x)) == tolower(static_cast<unsigned char>(y));
+        });
+    }
 
-                    Maintenance newMaintenance(0, equipmentId, description, scheduledDate, completionStatus);
-                    if (scheduleMaintenance(newMaintenance)) {
-                        cout << "Maintenance scheduled successfully." << endl;
+    static int fieldIndex(Kind kind, string_view name) {
+        const vector<string>& names = fieldNames(kind);
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (sameName(name, names[i])) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    static string_view trim(string_view v) {
+        while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+        while (!v.empty() && (v.back() == ' ' || v.back() == '\t' || v.back() == '\r')) v.remove_suffix(1);
+        return v;
+    }
+
+    // Splits one CSV line into its cells. Unquoted cells are views into the mapping;
+    // quoted cells with doubled quotes are unescaped into scratch.
+    static bool splitCsv(string_view line, vector<string_view>& cells, deque<string>& scratch) {
+        cells.clear();
+        size_t pos = 0;
+        while (true) {
+            if (pos < line.size() && line[pos] == '"') {
+                size_t start = ++pos;
+                bool escaped = false;
+                while (true) {
+                    size_t quote = line.find('"', pos);
+                    if (quote == string_view::npos) return false;
+                    if (quote + 1 < line.size() && line[quote + 1] == '"') {
+                        escaped = true;
+                        pos = quote + 2;
+                        continue;
+                    }
+                    string_view raw = line.substr(start, quote - start);
+                    if (escaped) {
+                        string& cell = scratch.emplace_back();
+                        for (size_t i = 0; i < raw.size(); ++i) {
+                            cell.push_back(raw[i]);
+                            if (raw[i] == '"') ++i;
+                        }
+                        cells.push_back(cell);
                     } else {
-                        cout << "Failed to schedule maintenance." << endl;
+                        cells.push_back(raw);
                     }
+                    pos = quote + 1;
                     break;
                 }
-                case 2:
-                    for (const auto& m : viewAll()) {
-                        m.display();
-                    }
-                    break;
-                case 3: {
-                    int scheduleId;
-                    cout << "Enter Schedule ID to view: ";
-                    cin >> scheduleId;
-                    if (auto maintenance = viewSchedule(scheduleId)) {
-                        maintenance->display();
-                    } else {
-                        cout << "Schedule with ID " << scheduleId << " not found." << endl;
-                    }
+                while (pos < line.size() && line[pos] != ',') ++pos;
+            } else {
+                size_t comma = line.find(',', pos);
+                size_t stop = comma == string_view::npos ? line.size() : comma;
+                cells.push_back(trim(line.substr(pos, stop - pos)));
+                pos = stop;
+            }
+            if (pos >= line.size()) return true;
+            ++pos;
+        }
+    }
+
+    static void appendUtf8(string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    // Parses a JSON string starting after its opening quote; escapes go to scratch.
+    static bool jsonString(string_view line, size_t& pos, string_view& value, deque<string>& scratch) {
+        size_t start = pos;
+        size_t end = line.find_first_of("\"\\", pos);
+        if (end == string_view::npos) return false;
+        if (line[end] == '"') {
+            value = line.substr(start, end - start);
+            pos = end + 1;
+            return true;
+        }
+        string& out = scratch.emplace_back(line.substr(start, end - start));
+        pos = end;
+        while (pos < line.size()) {
+            char c = line[pos++];
+            if (c == '"') {
+                value = out;
+                return true;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (pos >= line.size()) return false;
+            char e = line[pos++];
+            switch (e) {
+                case 'n': out.push_back('\n'); break;
+                case 't': out.push_back('\t'); break;
+                case 'r': out.push_back('\r'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'u': {
+                    if (pos + 4 > line.size()) return false;
+                    uint32_t cp = 0;
+                    auto parsed = from_chars(line.data() + pos, line.data() + pos + 4, cp, 16);
+                    if (parsed.ec != errc() || parsed.ptr != line.data() + pos + 4) return false;
+                    appendUtf8(out, cp);
+                    pos += 4;
                     break;
                 }
-                case 4: {
-                    int scheduleId, equipmentId;
-                    string description, completionStatus;
-                    time_t scheduledDate = time(nullptr);
+                default: out.push_back(e);
+            }
+        }
+        return false;
+    }
 
-                    cout << "Enter Schedule ID to update: ";
-                    cin >> scheduleId;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    cout << "Enter new Equipment ID: ";
-                    cin >> equipmentId;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    cout << "Enter new Description: ";
-                    getline(cin, description);
-                    cout << "Enter new Completion Status: ";
-                    getline(cin, completionStatus);
+    // Parses a flat JSON object; nested values are not supported.
+    static bool splitJson(Kind kind, string_view line, Fields& fields, deque<string>& scratch) {
+        size_t pos = line.find('{');
+        if (pos == string_view::npos) return false;
+        ++pos;
+        auto skipSpace = [&line, &pos]() {
+            while (pos < line.size() && isspace(static_cast<unsigned char>(line[pos]))) ++pos;
+        };
+        while (true) {
+            skipSpace();
+            if (pos < line.size() && line[pos] == '}') return true;
+            if (pos >= line.size() || line[pos] != '"') return false;
+            ++pos;
+            string_view key, value;
+            if (!jsonString(line, pos, key, scratch)) return false;
+            skipSpace();
+            if (pos >= line.size() || line[pos] != ':') return false;
+            ++pos;
+            skipSpace();
+            if (pos < line.size() && line[pos] == '"') {
+                ++pos;
+                if (!jsonString(line, pos, value, scratch)) return false;
+            } else {
+                size_t end = line.find_first_of(",}", pos);
+                if (end == string_view::npos) return false;
+                value = trim(line.substr(pos, end - pos));
+                if (value == "null") value = string_view();
+                pos = end;
+            }
+            int index = fieldIndex(kind, key);
+            if (index >= 0) {
+                fields.Values[index] = value;
+                fields.Present[index] = true;
+            }
+            skipSpace();
+            if (pos < line.size() && line[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            return pos < line.size() && line[pos] == '}';
+        }
+    }
 
-                    Maintenance updatedMaintenance(scheduleId, equipmentId, description, scheduledDate, completionStatus);
-                    if (updateSchedule(updatedMaintenance)) {
-                        cout << "Schedule updated successfully." << endl;
-                    } else {
-                        cout << "Failed to update schedule." << endl;
-                    }
+    static bool toInt(string_view v, int& out) {
+        v = trim(v);
+        auto parsed = from_chars(v.data(), v.data() + v.size(), out);
+        return !v.empty() && parsed.ec == errc() && parsed.ptr == v.data() + v.size();
+    }
+
+    static bool toTime(string_view v, time_t& out) {
+        return TimestampFormatter::parse(trim(v), out);
+    }
+
+    static const char* build(const Fields& f, Inventory& item) {
+        if (f.Values[0].empty()) return "missing ItemName";
+        if (!toInt(f.Values[2], item.Quantity) || item.Quantity < 0) return "invalid Quantity";
+        item.ItemName = string(f.Values[0]);
+        item.Category = f.Values[1];
+        item.Location = f.Values[3];
+        return nullptr;
+    }
+
+    static const char* build(const Fields& f, Shipment& shipment) {
+        if (!toInt(f.Values[0], shipment.ItemId) || shipment.ItemId <= 0) return "invalid ItemId";
+        if (f.Values[1].empty() || f.Values[2].empty()) return "missing Origin or Destination";
+        if (f.Present[4] && !f.Values[4].empty()) {
+            if (!toTime(f.Values[4], shipment.ExpectedDelivery)) return "invalid ExpectedDelivery";
+        } else {
+            shipment.ExpectedDelivery = time(nullptr) + (7 * 24 * 3600);
+        }
+        shipment.Origin = f.Values[1];
+        shipment.Destination = f.Values[2];
+        shipment.Status = f.Values[3];
+        return nullptr;
+    }
+
+    static const char* build(const Fields& f, Space& space) {
+        if (!toInt(f.Values[0], space.TotalCapacity) || space.TotalCapacity < 0) return "invalid TotalCapacity";
+        space.UsedCapacity = 0;
+        if (!f.Values[1].empty() && (!toInt(f.Values[1], space.UsedCapacity) || space.UsedCapacity < 0)) return "invalid UsedCapacity";
+        if (space.UsedCapacity > space.TotalCapacity) return "UsedCapacity exceeds TotalCapacity";
+        space.Zone = f.Values[2];
+        return nullptr;
+    }
+
+    // Manifest shipments have arrived, so they default to delivered now and are never late.
+    static const char* build(const Fields& f, ManifestLine& line) {
+        Shipment& shipment = line.Delivery;
+        if (!toInt(f.Values[0], shipment.ItemId) || shipment.ItemId <= 0) return "invalid ItemId";
+        if (!toInt(f.Values[1], line.Quantity) || line.Quantity <= 0) return "invalid Quantity";
+        if (!f.Values[2].empty() && (!toInt(f.Values[2], line.SpaceId) || line.SpaceId <= 0)) return "invalid SpaceId";
+        if (f.Values[3].empty() || f.Values[4].empty()) return "missing Origin or Destination";
+        if (!f.Values[6].empty()) {
+            if (!toTime(f.Values[6], shipment.ExpectedDelivery)) return "invalid ExpectedDelivery";
+        } else {
+            shipment.ExpectedDelivery = time(nullptr);
+        }
+        shipment.Origin = f.Values[3];
+        shipment.Destination = f.Values[4];
+        shipment.Status = f.Values[5].empty() ? string_view("delivered") : f.Values[5];
+        return nullptr;
+    }
+
+    template <typename T>
+    static void parseChunk(Kind kind, Format format, string_view chunk, const vector<int>& columns, ChunkResult<T>& result) {
+        vector<string_view> cells;
+        deque<string> scratch;
+        result.Records.reserve(static_cast<size_t>(count(chunk.begin(), chunk.end(), '\n')) + 1);
+        size_t pos = 0;
+        while (pos < chunk.size()) {
+            size_t newline = chunk.find('\n', pos);
+            size_t stop = newline == string_view::npos ? chunk.size() : newline;
+            string_view line = chunk.substr(pos, stop - pos);
+            pos = stop + 1;
+            result.Lines++;
+            if (trim(line).empty()) continue;
+
+            scratch.clear();
+            Fields fields;
+            bool parsed;
+            if (format == Format::Csv) {
+                parsed = splitCsv(line, cells, scratch);
+                for (size_t c = 0; parsed && c < cells.size() && c < columns.size(); ++c) {
+                    if (columns[c] < 0) continue;
+                    fields.Values[columns[c]] = cells[c];
+                    fields.Present[columns[c]] = true;
+                }
+            } else {
+                parsed = splitJson(kind, line, fields, scratch);
+            }
+            if (!parsed) {
+                result.Rejects.push_back(Reject{result.Lines, "malformed row", line});
+                continue;
+            }
+            T record;
+            if (const char* error = build(fields, record)) {
+                result.Rejects.push_back(Reject{result.Lines, error, line});
+                continue;
+            }
+            result.Records.push_back(move(record));
+        }
+    }
+
+    static bool insert(Warehouse& warehouse, Inventory& item) {
+        return warehouse.inventoryManager.addInventory(move(item));
+    }
+
+    static bool insert(Warehouse& warehouse, Shipment& shipment) {
+        return warehouse.shipmentRepo.receiveShipment(move(shipment));
+    }
+
+    static bool insert(Warehouse& warehouse, Space& space) {
+        return warehouse.spaceRepo.allocateSpace(move(space));
+    }
+
+    static void reserve(Warehouse& warehouse, Kind kind, size_t extra) {
+        if (kind == Kind::Inventory) {
+            warehouse.inventoryManager.reserve(warehouse.inventoryManager.records().size() + extra);
+        } else if (kind == Kind::Shipments || kind == Kind::Manifest) {
+            warehouse.shipmentRepo.reserve(warehouse.shipmentRepo.records().size() + extra);
+        } else {
+            warehouse.spaceRepo.reserve(warehouse.spaceRepo.records().size() + extra);
+        }
+    }
+
+    template <typename T>
+    static bool runTyped(Warehouse& warehouse, Journal* journal, Kind kind, Format format, const MappedFile& file,
+                         ofstream* rejects, Result& result) {
+        string_view text(file.data(), file.size());
+        size_t bodyStart = 0;
+        size_t headerLines = 0;
+        vector<int> columns;
+        if (format == Format::Csv) {
+            size_t newline = text.find('\n');
+            string_view header = text.substr(0, newline);
+            vector<string_view> cells;
+            deque<string> scratch;
+            if (!splitCsv(header, cells, scratch)) {
+                cerr << "Cannot parse the CSV header." << endl;
+                return false;
+            }
+            for (string_view cell : cells) columns.push_back(fieldIndex(kind, cell));
+            bodyStart = newline == string_view::npos ? text.size() : newline + 1;
+            headerLines = 1;
+        }
+
+        size_t workers = max<size_t>(1, thread::hardware_concurrency());
+        size_t minChunk = 1 << 20;
+        workers = min(workers, max<size_t>(1, (text.size() - bodyStart) / minChunk));
+        vector<string_view> chunks;
+        size_t begin = bodyStart;
+        for (size_t w = 0; w < workers && begin < text.size(); ++w) {
+            size_t end = w + 1 == workers ? text.size() : bodyStart + (text.size() - bodyStart) * (w + 1) / workers;
+            if (end < begin) end = begin;
+            size_t newline = text.find('\n', end);
+            end = newline == string_view::npos ? text.size() : newline + 1;
+            chunks.push_back(text.substr(begin, end - begin));
+            begin = end;
+        }
+
+        vector<ChunkResult<T>> results(chunks.size());
+        vector<thread> threads;
+        for (size_t c = 1; c < chunks.size(); ++c) {
+            threads.emplace_back(parseChunk<T>, kind, format, chunks[c], cref(columns), ref(results[c]));
+        }
+        if (!chunks.empty()) parseChunk<T>(kind, format, chunks[0], columns, results[0]);
+        for (auto& t : threads) t.join();
+
+        size_t total = 0;
+        for (const auto& r : results) total += r.Records.size();
+        reserve(warehouse, kind, total);
+
+        size_t lineBase = headerLines;
+        for (const auto& r : results) {
+            for (const auto& reject : r.Rejects) {
+                if (rejects) *rejects << "line " << lineBase + reject.Line << ": " << reject.Reason << ": " << reject.Text << '\n';
+                result.Rejected++;
+            }
+            lineBase += r.Lines;
+        }
+        return insertAll(warehouse, journal, results, result);
+    }
+
+    template <typename T>
+    static bool insertAll(Warehouse& warehouse, Journal* journal, vector<ChunkResult<T>>& results, Result& result) {
+        size_t inBatch = 0;
+        optional<Journal::DeferredCommit> batch;
+        for (auto& r : results) {
+            for (auto& record : r.Records) {
+                // Inserts only append to the journal; each batch commits once when it closes.
+                if (!batch) batch.emplace(journal);
+                if (insert(warehouse, record)) result.Imported++;
+                if (++inBatch == CommitBatch) {
+                    batch.reset();
+                    inBatch = 0;
+                }
+            }
+        }
+        return true;
+    }
+
+    static bool insertAll(Warehouse& warehouse, Journal*, vector<ChunkResult<ManifestLine>>& results, Result& result) {
+        if (result.Rejected) {
+            cerr << "Manifest has " << result.Rejected << " invalid line(s); nothing was received." << endl;
+            return false;
+        }
+        WarehouseBatch batch;
+        for (auto& r : results) {
+            for (auto& line : r.Records) batch.receive(move(line.Delivery), line.Quantity, line.SpaceId);
+        }
+        string error;
+        if (!warehouse.applyBatch(batch, error)) {
+            cerr << "Manifest rejected, " << error << "; nothing was received." << endl;
+            return false;
+        }
+        result.Imported = batch.Shipments.size();
+        return true;
+    }
+
+public:
+    static bool parseKind(const string& name, Kind& kind) {
+        if (name == "inventory") {
+            kind = Kind::Inventory;
+        } else if (name == "shipments") {
+            kind = Kind::Shipments;
+        } else if (name == "spaces") {
+            kind = Kind::Spaces;
+        } else if (name == "manifest") {
+            kind = Kind::Manifest;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Imports path into the warehouse, journaling in batches when a journal is attached.
+    static bool run(Warehouse& warehouse, Journal* journal, Kind kind, const string& path, const string& rejectPath, Result& result) {
+        auto start = chrono::steady_clock::now();
+        MappedFile file;
+        if (!file.open(path)) {
+            cerr << "Cannot open import file " << path << endl;
+            return false;
+        }
+        string lower = path;
+        transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+        auto endsWith = [&lower](const string& suffix) {
+            return lower.size() >= suffix.size() && lower.compare(lower.size() - suffix.size(), suffix.size(), suffix) == 0;
+        };
+        Format format = endsWith(".jsonl") || endsWith(".ndjson") || endsWith(".json") ? Format::JsonLines : Format::Csv;
+
+        ofstream rejects;
+        if (!rejectPath.empty()) {
+            rejects.open(rejectPath);
+            if (!rejects) {
+                cerr << "Cannot write reject file " << rejectPath << endl;
+                return false;
+            }
+        }
+        ofstream* rejectOut = rejectPath.empty() ? nullptr : &rejects;
+        bool ok;
+        if (kind == Kind::Inventory) {
+            ok = runTyped<Inventory>(warehouse, journal, kind, format, file, rejectOut, result);
+        } else if (kind == Kind::Shipments) {
+            ok = runTyped<Shipment>(warehouse, journal, kind, format, file, rejectOut, result);
+        } else if (kind == Kind::Manifest) {
+            ok = runTyped<ManifestLine>(warehouse, journal, kind, format, file, rejectOut, result);
+        } else {
+            ok = runTyped<Space>(warehouse, journal, kind, format, file, rejectOut, result);
+        }
+        result.Seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return ok;
+    }
+};
+
+// --- WarehouseServer Class ---
+// Request codes of the socket protocol. A frame is a u32 body length followed by the
+// body; request bodies start with the op, response bodies with a ResponseStatus, and
+// records travel in the same encoding the journal uses (writeTo / readFrom).
+enum class RequestOp : uint8_t {
+    Ping = 1,
+    SearchInventory,
+    AddInventory,
+    EditInventory,
+    DeleteInventory,
+    TrackShipment,
+    ReceiveShipment,
+    DispatchShipment,
+    RemoveShipment,
+    ViewSchedule,
+    ScheduleMaintenance,
+    UpdateSchedule,
+    SearchSpace,
+    ReserveCapacity,
+    ReleaseCapacity,
+    DownloadReport,
+    ExportInventory,
+    ExportShipments,
+    Metrics,
+    ApplyBatch,
+    SearchByName,
+    ReadChanges
+};
+
+enum class ResponseStatus : uint8_t { Ok = 0, NotFound, BadRequest, Rejected };
+
+#ifndef _WIN32
+constexpr uint32_t MaxFrameBytes = 16u << 20;
+
+bool readFull(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = recv(fd, data, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readFrame(int fd, string& body) {
+    uint32_t length;
+    if (!readFull(fd, reinterpret_cast<char*>(&length), sizeof(length)) || length > MaxFrameBytes) return false;
+    body.resize(length);
+    return readFull(fd, &body[0], length);
+}
+
+bool writeFull(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// `frame` must start with four bytes reserved for the length.
+bool writeFrame(int fd, string& frame) {
+    uint32_t length = static_cast<uint32_t>(frame.size() - sizeof(uint32_t));
+    memcpy(&frame[0], &length, sizeof(length));
+    return writeFull(fd, frame.data(), frame.size());
+}
+
+// Serves the repositories to many clients over a Unix socket. One poller thread owns
+// the idle connections and hands a connection with a pending request to the worker
+// pool; the worker answers that request and gives the connection back. Each
+// repository has its own reader-writer lock, so lookups run in parallel and writes
+// only exclude other users of the same repository. Journal waits happen after the
+// lock is released, letting group commit batch writers from different workers.
+class WarehouseServer {
+private:
+    Warehouse& warehouse;
+    Journal* journal;
+    shared_mutex inventoryLock;
+    shared_mutex maintenanceLock;
+    shared_mutex reportLock;
+    shared_mutex shipmentLock;
+    shared_mutex spaceLock;
+
+    string socketPath;
+    int listenFd = -1;
+    int wakeFds[2] = {-1, -1};
+    atomic<bool> stopping{false};
+    thread poller;
+    vector<thread> workers;
+
+    mutex queueMutex;
+    condition_variable queueCv;
+    deque<int> ready;
+    mutex returnMutex;
+    vector<int> returned;
+
+    static void put(string& response, ResponseStatus status) {
+        response.push_back(static_cast<char>(status));
+    }
+
+    // Encodes every record of a pinned version; runs with no repository lock held.
+    template <typename Snapshot>
+    static void putSnapshot(string& response, const Snapshot& snapshot) {
+        put(response, ResponseStatus::Ok);
+        ByteWriter out(response);
+        out.putI64(static_cast<int64_t>(snapshot.versionNumber()));
+        out.putI32(static_cast<int32_t>(snapshot.size()));
+        snapshot.forEach([&out](const auto& record) { record.writeTo(out); });
+    }
+
+    template <typename T>
+    static void putRecord(string& response, const T* record) {
+        if (!record) {
+            put(response, ResponseStatus::NotFound);
+            return;
+        }
+        put(response, ResponseStatus::Ok);
+        ByteWriter out(response);
+        record->writeTo(out);
+    }
+
+    static void putId(string& response, int id) {
+        put(response, id ? ResponseStatus::Ok : ResponseStatus::Rejected);
+        ByteWriter(response).putI32(id);
+    }
+
+    static void putResult(string& response, bool ok) {
+        put(response, ok ? ResponseStatus::Ok : ResponseStatus::NotFound);
+    }
+
+    void handle(const string& request, string& response) {
+        ByteReader in(request.data(), request.size());
+        RequestOp op = static_cast<RequestOp>(in.getU8());
+        // Writes append to the journal under their lock but wait for it afterwards.
+        optional<Journal::DeferredCommit> commit;
+        if (journal && op != RequestOp::Ping && op != RequestOp::SearchInventory && op != RequestOp::TrackShipment &&
+            op != RequestOp::ViewSchedule && op != RequestOp::SearchSpace && op != RequestOp::ExportInventory &&
+            op != RequestOp::ExportShipments && op != RequestOp::Metrics && op != RequestOp::SearchByName &&
+            op != RequestOp::ReadChanges) {
+            commit.emplace(journal);
+        }
+        size_t start = response.size();
+        switch (op) {
+            case RequestOp::Ping: {
+                shared_lock<shared_mutex> a(inventoryLock), b(maintenanceLock), c(reportLock), d(shipmentLock), e(spaceLock);
+                put(response, ResponseStatus::Ok);
+                ByteWriter out(response);
+                out.putI32(warehouse.inventoryManager.nextId());
+                out.putI32(warehouse.maintenanceRepo.nextId());
+                out.putI32(warehouse.reportRepo.nextId());
+                out.putI32(warehouse.shipmentRepo.nextId());
+                out.putI32(warehouse.spaceRepo.nextId());
+                break;
+            }
+            case RequestOp::SearchInventory: {
+                int id = in.getI32();
+                shared_lock<shared_mutex> lock(inventoryLock);
+                putRecord(response, static_cast<const InventoryManager&>(warehouse.inventoryManager).searchInventory(id));
+                break;
+            }
+            case RequestOp::AddInventory: {
+                Inventory item = Inventory::readFrom(in);
+                if (!in.ok()) break;
+                item.LastUpdated = time(nullptr);
+                unique_lock<shared_mutex> lock(inventoryLock);
+                warehouse.inventoryManager.addInventory(move(item));
+                putId(response, warehouse.inventoryManager.nextId() - 1);
+                break;
+            }
+            case RequestOp::EditInventory: {
+                Inventory item = Inventory::readFrom(in);
+                if (!in.ok()) break;
+                item.LastUpdated = time(nullptr);
+                unique_lock<shared_mutex> lock(inventoryLock);
+                putResult(response, warehouse.inventoryManager.editInventory(move(item)));
+                break;
+            }
+            case RequestOp::DeleteInventory: {
+                int id = in.getI32();
+                if (!in.ok()) break;
+                unique_lock<shared_mutex> lock(inventoryLock);
+                shared_lock<shared_mutex> shipments(shipmentLock);
+                if (warehouse.inventoryManager.hasReferences(id)) {
+                    put(response, ResponseStatus::Rejected);
+                } else {
+                    putResult(response, warehouse.inventoryManager.deleteInventory(id));
+                }
+                break;
+            }
+            case RequestOp::TrackShipment: {
+                int id = in.getI32();
+                shared_lock<shared_mutex> lock(shipmentLock);
+                putRecord(response, static_cast<const ShipmentRepository&>(warehouse.shipmentRepo).trackShipment(id));
+                break;
+            }
+            case RequestOp::ReceiveShipment: {
+                Shipment shipment = Shipment::readFrom(in);
+                if (!in.ok()) break;
+                shared_lock<shared_mutex> items(inventoryLock);
+                unique_lock<shared_mutex> lock(shipmentLock);
+                bool received = warehouse.shipmentRepo.receiveShipment(move(shipment));
+                putId(response, received ? warehouse.shipmentRepo.nextId() - 1 : 0);
+                break;
+            }
+            case RequestOp::DispatchShipment: {
+                Shipment shipment = Shipment::readFrom(in);
+                if (!in.ok()) break;
+                shared_lock<shared_mutex> items(inventoryLock);
+                unique_lock<shared_mutex> lock(shipmentLock);
+                ShipmentRepository& shipments = warehouse.shipmentRepo;
+                if (shipments.dispatchShipment(shipment)) {
+                    put(response, ResponseStatus::Ok);
+                } else {
+                    put(response, shipments.trackShipment(shipment.ShipmentId) ? ResponseStatus::Rejected : ResponseStatus::NotFound);
+                }
+                break;
+            }
+            case RequestOp::RemoveShipment: {
+                int id = in.getI32();
+                if (!in.ok()) break;
+                unique_lock<shared_mutex> lock(shipmentLock);
+                putResult(response, warehouse.shipmentRepo.removeShipment(id));
+                break;
+            }
+            case RequestOp::ViewSchedule: {
+                int id = in.getI32();
+                shared_lock<shared_mutex> lock(maintenanceLock);
+                putRecord(response, static_cast<const MaintenanceRepository&>(warehouse.maintenanceRepo).viewSchedule(id));
+                break;
+            }
+            case RequestOp::ScheduleMaintenance: {
+                Maintenance m = Maintenance::readFrom(in);
+                if (!in.ok()) break;
+                unique_lock<shared_mutex> lock(maintenanceLock);
+                warehouse.maintenanceRepo.scheduleMaintenance(move(m));
+                putId(response, warehouse.maintenanceRepo.nextId() - 1);
+                break;
+            }
+            case RequestOp::UpdateSchedule: {
+                Maintenance m = Maintenance::readFrom(in);
+                if (!in.ok()) break;
+                unique_lock<shared_mutex> lock(maintenanceLock);
+                putResult(response, warehouse.maintenanceRepo.updateSchedule(move(m)));
+                break;
+            }
+            case RequestOp::SearchSpace: {
+                int id = in.getI32();
+                shared_lock<shared_mutex> lock(spaceLock);
+                putRecord(response, static_cast<const SpaceRepository&>(warehouse.spaceRepo).searchSpace(id));
+                break;
+            }
+            case RequestOp::ReserveCapacity: {
+                int units = in.getI32();
+                string zone = in.getString();
+                if (!in.ok()) break;
+                unique_lock<shared_mutex> lock(spaceLock);
+                putId(response, warehouse.spaceRepo.reserveCapacity(units, zone.empty() ? nullopt : optional<string>(zone)));
+                break;
+            }
+            case RequestOp::ReleaseCapacity: {
+                int id = in.getI32();
+                int units = in.getI32();
+                if (!in.ok()) break;
+                unique_lock<shared_mutex> lock(spaceLock);
+                putResult(response, warehouse.spaceRepo.releaseCapacity(id, units));
+                break;
+            }
+            case RequestOp::DownloadReport: {
+                int id = in.getI32();
+                if (!in.ok()) break;
+                // Built-in reports read every repository's totals; locks are taken in declaration order.
+                shared_lock<shared_mutex> a(inventoryLock), b(maintenanceLock);
+                shared_lock<shared_mutex> c(reportLock), d(shipmentLock), e(spaceLock);
+                optional<Report> report = warehouse.reportRepo.downloadReport(id);
+                putRecord(response, report ? &*report : nullptr);
+                break;
+            }
+            case RequestOp::ExportInventory: {
+                VersionedRecords<Inventory>::Snapshot snapshot;
+                {
+                    shared_lock<shared_mutex> lock(inventoryLock);
+                    snapshot = warehouse.inventoryManager.snapshot();
+                }
+                putSnapshot(response, snapshot);
+                break;
+            }
+            case RequestOp::ExportShipments: {
+                VersionedRecords<Shipment>::Snapshot snapshot;
+                {
+                    shared_lock<shared_mutex> lock(shipmentLock);
+                    snapshot = warehouse.shipmentRepo.snapshot();
+                }
+                putSnapshot(response, snapshot);
+                break;
+            }
+            case RequestOp::Metrics: {
+                // Counters are per thread and need no lock; the gauges read repository sizes.
+                ostringstream text;
+                {
+                    shared_lock<shared_mutex> a(inventoryLock), b(maintenanceLock), c(reportLock), d(shipmentLock), e(spaceLock);
+                    writeMetrics(text, warehouse);
+                }
+                put(response, ResponseStatus::Ok);
+                ByteWriter(response).putString(text.str());
+                break;
+            }
+            case RequestOp::ApplyBatch: {
+                // Replies with the first new shipment ID, or Rejected and the reason.
+                WarehouseBatch batch = WarehouseBatch::readFrom(in);
+                if (!in.ok()) break;
+                batch.Timestamp = 0;
+                for (auto& s : batch.Shipments) s.ShipmentId = 0;
+                string error;
+                unique_lock<shared_mutex> a(inventoryLock), b(shipmentLock), c(spaceLock);
+                if (warehouse.applyBatch(batch, error)) {
+                    put(response, ResponseStatus::Ok);
+                    ByteWriter(response).putI32(batch.Shipments.empty() ? 0 : batch.Shipments.front().ShipmentId);
+                } else {
+                    put(response, ResponseStatus::Rejected);
+                    ByteWriter(response).putString(error);
+                }
+                break;
+            }
+            case RequestOp::SearchByName: {
+                // Request: match type, result limit, query. Replies with the matching items, best first.
+                uint8_t mode = in.getU8();
+                int32_t limit = in.getI32();
+                string query = in.getString();
+                if (!in.ok() || mode > static_cast<uint8_t>(NameMatch::Fuzzy) || limit < 0) break;
+                const InventoryManager& inventory = warehouse.inventoryManager;
+                shared_lock<shared_mutex> lock(inventoryLock);
+                vector<int> ids = inventory.searchByName(query, static_cast<NameMatch>(mode), static_cast<size_t>(limit));
+                put(response, ResponseStatus::Ok);
+                ByteWriter out(response);
+                out.putI32(static_cast<int32_t>(ids.size()));
+                for (int id : ids) inventory.searchInventory(id)->writeTo(out);
+                break;
+            }
+            case RequestOp::ReadChanges: {
+                // Request: the sequence to read from, event limit. Replies with the sequence to
+                // ask for next, the positions skipped because they had left the ring, and the
+                // events as [sequence][time][payload]. Takes no repository lock.
+                int64_t from = in.getI64();
+                int32_t limit = in.getI32();
+                if (!in.ok() || limit < 0) break;
+                ChangeStream* stream = journal ? journal->changeStream() : nullptr;
+                if (!stream) {
+                    put(response, ResponseStatus::NotFound);
                     break;
                 }
-                case 5: {
-                    int scheduleId;
-                    cout << "Enter Schedule ID to remove: ";
-                    cin >> scheduleId;
-                    if (removeMaintenance(scheduleId)) {
-                        cout << "Schedule removed successfully." << endl;
+                put(response, ResponseStatus::Ok);
+                size_t header = response.size();
+                response.append(2 * sizeof(int64_t) + sizeof(int32_t), '\0');
+                ByteWriter out(response);
+                uint64_t cursor = static_cast<uint64_t>(from);
+                uint64_t skipped = 0;
+                int32_t count = 0;
+                auto encode = [&out](const ChangeEvent& e) {
+                    out.putI64(static_cast<int64_t>(e.Sequence));
+                    out.putI64(e.TimeMicros);
+                    out.putString(e.Payload);
+                };
+                while (count < limit) {
+                    uint64_t before = cursor;
+                    uint64_t lost = skipped;
+                    size_t size = response.size();
+                    if (!stream->read(cursor, 1, skipped, encode)) break;
+                    if (response.size() - sizeof(uint32_t) <= MaxFrameBytes) {
+                        count++;
+                        continue;
+                    }
+                    // Too big for this reply: leave it for the next one, or skip it if it can never fit.
+                    response.resize(size);
+                    if (count > 0) {
+                        cursor = before;
+                        skipped = lost;
                     } else {
-                        cout << "Schedule with ID " << scheduleId << " not found." << endl;
+                        skipped = lost + (cursor - before);
                     }
                     break;
                 }
-                case 0:
-                    cout << "Returning to Main Menu." << endl;
-                    break;
-                default:
-                    cout << "Invalid choice. Please try again." << endl;
+                int64_t next = static_cast<int64_t>(cursor);
+                int64_t lost = static_cast<int64_t>(skipped);
+                memcpy(&response[header], &next, sizeof(next));
+                memcpy(&response[header + sizeof(next)], &lost, sizeof(lost));
+                memcpy(&response[header + 2 * sizeof(int64_t)], &count, sizeof(count));
+                break;
+            }
+        }
+        if (response.size() == start) put(response, ResponseStatus::BadRequest);
+    }
+
+    void wake() {
+        char byte = 0;
+        while (write(wakeFds[1], &byte, 1) < 0 && errno == EINTR) {
+        }
+    }
+
+    void giveBack(int fd) {
+        {
+            lock_guard<mutex> lock(returnMutex);
+            returned.push_back(fd);
+        }
+        wake();
+    }
+
+    void workerLoop() {
+        string request;
+        string response;
+        while (true) {
+            int fd;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueCv.wait(lock, [this] { return stopping || !ready.empty(); });
+                if (ready.empty()) return;
+                fd = ready.front();
+                ready.pop_front();
+            }
+            if (!readFrame(fd, request)) {
+                close(fd);
+                continue;
+            }
+            response.assign(sizeof(uint32_t), '\0');
+            handle(request, response);
+            if (!writeFrame(fd, response)) {
+                close(fd);
+                continue;
+            }
+            giveBack(fd);
+        }
+    }
+
+    void pollLoop() {
+        vector<int> idle;
+        vector<pollfd> fds;
+        while (!stopping) {
+            fds.clear();
+            fds.push_back(pollfd{listenFd, POLLIN, 0});
+            fds.push_back(pollfd{wakeFds[0], POLLIN, 0});
+            for (int fd : idle) fds.push_back(pollfd{fd, POLLIN, 0});
+            if (poll(fds.data(), fds.size(), 200) < 0 && errno != EINTR) break;
+
+            vector<int> stillIdle;
+            vector<int> busy;
+            for (size_t i = 2; i < fds.size(); ++i) {
+                (fds[i].revents ? busy : stillIdle).push_back(fds[i].fd);
+            }
+            idle.swap(stillIdle);
+            if (fds[1].revents & POLLIN) {
+                char drain[256];
+                while (read(wakeFds[0], drain, sizeof(drain)) > 0) {
+                }
+                lock_guard<mutex> lock(returnMutex);
+                idle.insert(idle.end(), returned.begin(), returned.end());
+                returned.clear();
             }
-        } while (choice != 0);
+            if (fds[0].revents & POLLIN) {
+                int fd;
+                while ((fd = accept(listenFd, nullptr, nullptr)) >= 0) idle.push_back(fd);
+            }
+            if (!busy.empty()) {
+                lock_guard<mutex> lock(queueMutex);
+                ready.insert(ready.end(), busy.begin(), busy.end());
+                queueCv.notify_all();
+            }
+        }
+        for (int fd : idle) close(fd);
     }
-};
 
-// --- Report Class ---
-class Report {
 public:
-    int ReportId;
-    string ReportType;
-    time_t GeneratedOn;
-    string Details;
+    // Exports scan pinned versions of the inventory and shipments, so a long export
+    // holds their locks only while the version is taken.
+    WarehouseServer(Warehouse& w, Journal* j) : warehouse(w), journal(j) {
+        warehouse.inventoryManager.enableVersions();
+        warehouse.shipmentRepo.enableVersions();
+    }
 
-    Report(int reportId = 0, string reportType = "", time_t generatedOn = 0, string details = "")
-        : ReportId(reportId), ReportType(reportType), GeneratedOn(generatedOn), Details(details) {}
+    ~WarehouseServer() {
+        stop();
+    }
 
-    void display() const {
-        cout << "Report ID: " << ReportId << endl;
-        cout << "Report Type: " << ReportType << endl;
-        cout << "Generated On: " << formatDate(GeneratedOn) << endl;
-        cout << "Details: " << Details << endl;
-        cout << "-------------------------" << endl;
+    bool start(const string& path, int workerCount) {
+        socketPath = path;
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            cerr << "Socket path is too long: " << path << endl;
+            return false;
+        }
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        unlink(path.c_str());
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listenFd, 128) != 0 || pipe(wakeFds) != 0) {
+            cerr << "Cannot listen on " << path << ": " << strerror(errno) << endl;
+            return false;
+        }
+        fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+        fcntl(wakeFds[0], F_SETFL, fcntl(wakeFds[0], F_GETFL) | O_NONBLOCK);
+        stopping = false;
+        for (int i = 0; i < max(1, workerCount); ++i) workers.emplace_back(&WarehouseServer::workerLoop, this);
+        poller = thread(&WarehouseServer::pollLoop, this);
+        return true;
     }
 
-private:
-    string formatDate(time_t time) const {
-        tm t;
-#ifdef _MSC_VER
-        localtime_s(&t, &time);
-#else
-        localtime_r(&time, &t);
-#endif
-        stringstream ss;
-        ss << put_time(&t, "%Y-%m-%d %H:%M:%S");
-        return ss.str();
+    // Finishes the requests in progress, then closes every connection.
+    void stop() {
+        if (listenFd < 0) return;
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueCv.notify_all();
+        wake();
+        if (poller.joinable()) poller.join();
+        for (auto& t : workers) t.join();
+        workers.clear();
+        for (int fd : ready) close(fd);
+        ready.clear();
+        for (int fd : returned) close(fd);
+        returned.clear();
+        close(listenFd);
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+        listenFd = -1;
+        unlink(socketPath.c_str());
     }
 };
 
-// --- ReportRepository Class ---
-class ReportRepository {
+// --- ChangeTail Class ---
+// The built-in change consumer: a thread that copies every change event to a file
+// (appending) or to a Unix socket another process listens on, as frames of
+// [length][sequence][time][payload]. It subscribes with Block, so writers slow to the
+// target's pace instead of losing events to it. A socket that goes away is retried
+// every second, and the tail resumes from its cursor with what the ring still holds.
+class ChangeTail {
 private:
-    vector<Report> reports;
-    int nextReportId = 1;
+    ChangeStream& stream;
+    string target;
+    bool toSocket;
+    int subscriber = -1;
+    FILE* file = nullptr;
+    int fd = -1;
+    atomic<bool> stopping{false};
+    thread worker;
+
+    bool connectSocket() {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (target.size() >= sizeof(address.sun_path)) return false;
+        memcpy(address.sun_path, target.c_str(), target.size() + 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) return true;
+        if (fd >= 0) close(fd);
+        fd = -1;
+        return false;
+    }
+
+    bool deliver(const string& frames) {
+        if (!toSocket) return fwrite(frames.data(), 1, frames.size(), file) == frames.size() && fflush(file) == 0;
+        if (fd < 0 && !connectSocket()) return false;
+        if (writeFull(fd, frames.data(), frames.size())) return true;
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // Delivers up to 256 events per write; the cursor only moves once they are delivered.
+    void run() {
+        string frames;
+        uint64_t skipped = 0;
+        bool failing = false;
+        auto encode = [&frames](const ChangeEvent& e) {
+            uint32_t length = static_cast<uint32_t>(2 * sizeof(int64_t) + e.Payload.size());
+            frames.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            ByteWriter out(frames);
+            out.putI64(static_cast<int64_t>(e.Sequence));
+            out.putI64(e.TimeMicros);
+            frames.append(e.Payload);
+        };
+        while (true) {
+            bool draining = stopping.load();
+            uint64_t cursor = stream.position(subscriber);
+            frames.clear();
+            size_t count = stream.read(cursor, 256, skipped, encode);
+            if (skipped && !failing) {
+                cerr << "Change tail to " << target << " missed " << skipped << " position(s) of events." << endl;
+                skipped = 0;
+            }
+            if (count == 0) {
+                stream.advance(subscriber, cursor);
+                if (draining) break;
+                stream.waitFor(cursor, chrono::milliseconds(100));
+            } else if (deliver(frames)) {
+                stream.advance(subscriber, cursor);
+                failing = false;
+            } else {
+                if (!failing) cerr << "Cannot deliver changes to " << target << "; retrying." << endl;
+                failing = true;
+                if (draining) break;
+                for (int i = 0; i < 10 && !stopping; ++i) this_thread::sleep_for(chrono::milliseconds(100));
+            }
+        }
+    }
 
 public:
-    bool generateReport(Report a) {
-        a.ReportId = nextReportId++;
-        reports.push_back(a);
-        return true;
+    ChangeTail(ChangeStream& s, const string& path, bool socketTarget) : stream(s), target(path), toSocket(socketTarget) {}
+
+    ~ChangeTail() {
+        stop();
     }
 
-    Report* downloadReport(int id) {
-        for (auto& r : reports) {
-            if (r.ReportId == id) {
-                return &r;
+    bool start() {
+        if (toSocket) {
+            signal(SIGPIPE, SIG_IGN);
+            if (!connectSocket()) {
+                cerr << "Cannot connect to " << target << ": " << strerror(errno) << endl;
+                return false;
             }
+        } else if (!(file = fopen(target.c_str(), "ab"))) {
+            cerr << "Cannot open " << target << endl;
+            return false;
         }
-        return nullptr;
+        subscriber = stream.subscribe(Backpressure::Block);
+        if (subscriber < 0) {
+            cerr << "Too many change subscribers." << endl;
+            return false;
+        }
+        worker = thread(&ChangeTail::run, this);
+        return true;
     }
 
-    vector<Report> viewReports() const {
-        return reports;
+    // Delivers what is still pending, unless the target is failing, then closes it.
+    void stop() {
+        stopping = true;
+        if (worker.joinable()) worker.join();
+        if (subscriber >= 0) stream.unsubscribe(subscriber);
+        subscriber = -1;
+        if (file) fclose(file);
+        file = nullptr;
+        if (fd >= 0) close(fd);
+        fd = -1;
     }
+};
 
-    void reportSubMenu() {
-        int choice;
-        do {
-            cout << "\n--- Report Management ---" << endl;
-            cout << "1. Generate Report" << endl;
-            cout << "2. View All Reports" << endl;
-            cout << "3. Download Report" << endl;
-            cout << "0. Back to Main Menu" << endl;
-            cout << "Enter your choice: ";
-            cin >> choice;
+// --- Load Generator ---
+// Client side of the protocol: one connection per client thread, issuing a mix of
+// shipment and inventory lookups with a share of writes, timed per request.
+class LoadGenerator {
+private:
+    int fd = -1;
+    string frame;
+    string reply;
 
-            if (cin.fail()) {
-                cerr << "Invalid input. Please enter a number." << endl;
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                choice = -1;
-                continue;
-            }
+public:
+    ~LoadGenerator() {
+        if (fd >= 0) close(fd);
+    }
 
-            switch (choice) {
-                case 1: {
-                    string reportType, details;
-                    time_t generatedOn = time(nullptr);
+    bool connectTo(const string& path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) return false;
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        return fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    }
 
-                    cout << "Enter Report Type: ";
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    getline(cin, reportType);
-                    cout << "Enter Report Details: ";
-                    getline(cin, details);
+    // Sends one request and returns its response status (BadRequest on a broken connection).
+    template <typename Encode>
+    ResponseStatus call(RequestOp op, Encode encode) {
+        frame.assign(sizeof(uint32_t), '\0');
+        frame.push_back(static_cast<char>(op));
+        ByteWriter out(frame);
+        encode(out);
+        if (!writeFrame(fd, frame) || !readFrame(fd, reply) || reply.empty()) return ResponseStatus::BadRequest;
+        return static_cast<ResponseStatus>(reply[0]);
+    }
 
-                    Report newReport(0, reportType, generatedOn, details);
-                    if (generateReport(newReport)) {
-                        cout << "Report generated successfully." << endl;
-                    } else {
-                        cout << "Failed to generate report." << endl;
-                    }
-                    break;
+    const string& lastReply() const {
+        return reply;
+    }
+
+    static int run(const string& path, int clients, int requests, int writePercent) {
+        static const char* cities[] = {"Chicago", "Dallas", "Newark", "Oakland", "Savannah"};
+        LoadGenerator probe;
+        if (!probe.connectTo(path) || probe.call(RequestOp::Ping, [](ByteWriter&) {}) != ResponseStatus::Ok) {
+            cerr << "Cannot reach the server at " << path << endl;
+            return 1;
+        }
+        ByteReader ids(probe.lastReply().data() + 1, probe.lastReply().size() - 1);
+        int itemCount = ids.getI32() - 1;
+        ids.getI32();
+        ids.getI32();
+        int shipmentCount = ids.getI32() - 1;
+        for (; itemCount < 1000; ++itemCount) {
+            probe.call(RequestOp::AddInventory, [itemCount](ByteWriter& out) {
+                Inventory(0, "Load item " + to_string(itemCount), "Hardware", 100, "Aisle 1").writeTo(out);
+            });
+        }
+        for (; shipmentCount < 1000; ++shipmentCount) {
+            probe.call(RequestOp::ReceiveShipment, [](ByteWriter& out) {
+                Shipment(0, 1, "Chicago", "Dallas", "in-transit", time(nullptr)).writeTo(out);
+            });
+        }
+
+        vector<vector<double>> latencies(static_cast<size_t>(clients));
+        atomic<int> failures{0};
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (int c = 0; c < clients; ++c) {
+            threads.emplace_back([&, c]() {
+                LoadGenerator client;
+                if (!client.connectTo(path)) {
+                    failures += requests;
+                    return;
                 }
-                case 2:
-                    for (const auto& r : viewReports()) {
-                        r.display();
-                    }
-                    break;
-                case 3: {
-                    int reportId;
-                    cout << "Enter Report ID to download: ";
-                    cin >> reportId;
-                    if (auto report = downloadReport(reportId)) {
-                        report->display();
+                vector<double>& mine = latencies[static_cast<size_t>(c)];
+                mine.reserve(static_cast<size_t>(requests));
+                uint64_t state = 88172645463325252ull + static_cast<uint64_t>(c) * 7919;
+                for (int i = 0; i < requests; ++i) {
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    int pick = static_cast<int>(state % 100);
+                    int id = static_cast<int>((state >> 8) % static_cast<uint64_t>(shipmentCount)) + 1;
+                    int itemId = static_cast<int>((state >> 20) % static_cast<uint64_t>(itemCount)) + 1;
+                    auto begin = chrono::steady_clock::now();
+                    ResponseStatus status;
+                    if (pick < writePercent) {
+                        status = client.call(RequestOp::ReceiveShipment, [&](ByteWriter& out) {
+                            Shipment(0, itemId, cities[id % 5], cities[(id + 1) % 5], "in-transit", time(nullptr)).writeTo(out);
+                        });
+                    } else if (pick % 2) {
+                        status = client.call(RequestOp::TrackShipment, [id](ByteWriter& out) { out.putI32(id); });
                     } else {
-                        cout << "Report with ID " << reportId << " not found." << endl;
+                        status = client.call(RequestOp::SearchInventory, [itemId](ByteWriter& out) { out.putI32(itemId); });
                     }
-                    break;
+                    mine.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count());
+                    if (status == ResponseStatus::BadRequest) failures++;
                 }
-                case 0:
-                    cout << "Returning to Main Menu." << endl;
-                    break;
-                default:
-                    cout << "Invalid choice. Please try again." << endl;
-            }
-        } while (choice != 0);
+            });
+        }
+        for (auto& t : threads) t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        vector<double> all;
+        for (auto& v : latencies) all.insert(all.end(), v.begin(), v.end());
+        if (all.empty()) {
+            cerr << "No requests completed." << endl;
+            return 1;
+        }
+        sort(all.begin(), all.end());
+        auto percentile = [&all](double p) { return all[min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+        cout << clients << " client(s), " << all.size() << " requests, " << writePercent << "% writes" << endl;
+        cout << "Throughput: " << fixed << setprecision(0) << all.size() / seconds << " requests/s" << endl;
+        cout << "Latency: p50 " << setprecision(1) << percentile(0.50) << " us, p99 " << percentile(0.99) << " us, max "
+             << all.back() << " us" << endl;
+        if (failures) cerr << failures << " request(s) failed." << endl;
+        return failures ? 1 : 0;
     }
 };
+#endif
 
-// --- Shipment Class ---
-class Shipment {
-public:
-    int ShipmentId;
-    int ItemId;
-    string Origin;
-    string Destination;
-    string Status;
-    time_t ExpectedDelivery;
-    Inventory* InventoryPtr = nullptr; // Simulate ForeignKey
+// --- WarehouseGenerator Class ---
+// Deterministic synthetic warehouse records. The same seed always yields the same
+// sequence, so runs on different builds are comparable.
+class WarehouseGenerator {
+private:
+    uint64_t state;
 
-    Shipment(int shipmentId = 0, int itemId = 0, string origin = "", string destination = "", string status = "", time_t expectedDelivery = 0)
-        : ShipmentId(shipmentId), ItemId(itemId), Origin(origin), Destination(destination), Status(status), ExpectedDelivery(expectedDelivery) {}
+public:
+    explicit WarehouseGenerator(uint64_t seed = 88172645463325252ull) : state(seed) {}
 
-    void display() const {
-        cout << "Shipment ID: " << ShipmentId << endl;
-        cout << "Item ID: " << ItemId << endl;
-        cout << "Origin: " << Origin << endl;
-        cout << "Destination: " << Destination << endl;
-        cout << "Status: " << Status << endl;
-        cout << "Expected Delivery: " << formatDate(ExpectedDelivery) << endl;
-        cout << "-------------------------" << endl;
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
     }
 
-private:
-    string formatDate(time_t time) const {
-        tm t;
-#ifdef _MSC_VER
-        localtime_s(&t, &time);
-#else
-        localtime_r(&time, &t);
-#endif
-        stringstream ss;
-        ss << put_time(&t, "%Y-%m-%d %H:%M:%S");
-        return ss.str();
+    // Uniform ID in [1, count].
+    int pick(int count) {
+        return static_cast<int>(next() % static_cast<uint64_t>(max(1, count))) + 1;
     }
-};
 
-// --- ShipmentRepository Class ---
-class ShipmentRepository {
-private:
-    vector<Shipment> shipments;
-    int nextShipmentId = 1;
+    Inventory item() {
+        static const char* categories[] = {"Hardware", "Electrical", "Plumbing", "Packaging", "Tools", "Safety"};
+        uint64_t r = next();
+        return Inventory(0, "Item " + to_string(r % 1000000), categories[r % 6], static_cast<int>(r % 500),
+                         "Aisle " + to_string((r >> 20) % 200));
+    }
 
-public:
-    bool receiveShipment(Shipment shipment) {
-        shipment.ShipmentId = nextShipmentId++;
-        shipments.push_back(shipment);
-        return true;
+    Shipment shipment(int itemCount) {
+        static const char* cities[] = {"Chicago", "Dallas", "Newark", "Oakland", "Savannah", "Seattle", "Memphis"};
+        static const char* statuses[] = {"pending", "in-transit", "delayed", "delivered"};
+        uint64_t r = next();
+        return Shipment(0, pick(itemCount), cities[r % 7], cities[(r >> 8) % 7], statuses[(r >> 16) % 4],
+                        1700000000 + static_cast<time_t>((r >> 24) % 5000000));
     }
 
-    bool removeShipment(int shipmentId) {
-        auto it = remove_if(shipments.begin(), shipments.end(),
-                            [shipmentId](const Shipment& s){ return s.ShipmentId == shipmentId; });
-        if (it != shipments.end()) {
-            shipments.erase(it, shipments.end());
-            return true;
-        }
-        return false;
+    Space space() {
+        static const char* zones[] = {"North", "South", "East", "West", "Cold"};
+        uint64_t r = next();
+        int total = 100 + static_cast<int>(r % 900);
+        return Space(0, total, static_cast<int>((r >> 16) % static_cast<uint64_t>(total)), zones[(r >> 32) % 5]);
     }
 
-    bool dispatchShipment(Shipment shipment) {
-        for (auto& s : shipments) {
-            if (s.ShipmentId == shipment.ShipmentId) {
-                s.ItemId = shipment.ItemId;
-                s.Origin = shipment.Origin;
-                s.Destination = shipment.Destination;
-                s.Status = shipment.Status;
-                s.ExpectedDelivery = shipment.ExpectedDelivery;
-                return true;
-            }
-        }
-        return false;
+    Maintenance maintenance() {
+        uint64_t r = next();
+        return Maintenance(0, static_cast<int>(r % 5000) + 1, "Inspect unit " + to_string(r % 5000),
+                           1700000000 + static_cast<time_t>((r >> 16) % 5000000), r % 3 ? "pending" : "completed");
     }
 
-    Shipment* trackShipment(int id) {
-        for (auto& s : shipments) {
-            if (s.ShipmentId == id) {
-                return &s;
-            }
-        }
-        return nullptr;
+    Report report() {
+        uint64_t r = next();
+        return Report(0, "Audit", 1700000000 + static_cast<time_t>(r % 5000000), "Cycle count " + to_string(r % 100000));
     }
+};
 
-    vector<Shipment> viewShipment() const {
-        return shipments;
+// --- Lookup Benchmark ---
+// Compares the old linear scan against the primary-key index on `records` shipments.
+void runLookupBenchmark(int records) {
+    ShipmentRepository shipmentRepo;
+    for (int i = 0; i < records; ++i) {
+        shipmentRepo.receiveShipment(Shipment(0, i % 1000 + 1, "Origin", "Destination", "in-transit", 0));
     }
+    RecordView<Shipment> all = shipmentRepo.viewShipment();
 
-    void shipmentSubMenu() {
-        int choice;
-        do {
-            cout << "\n--- Shipment Management ---" << endl;
-            cout << "1. Receive Shipment" << endl;
-            cout << "2. View All Shipments" << endl;
-            cout << "3. Track Shipment" << endl;
-            cout << "4. Dispatch Shipment" << endl;
-            cout << "5. Remove Shipment" << endl;
-            cout << "0. Back to Main Menu" << endl;
-            cout << "Enter your choice: ";
-            cin >> choice;
+    const int scanLookups = 200;
+    const int indexedLookups = 1000000;
+    WarehouseGenerator gen;
+    auto nextId = [&gen, records]() { return gen.pick(records); };
 
-            if (cin.fail()) {
-                cerr << "Invalid input. Please enter a number." << endl;
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                choice = -1;
-                continue;
+    long long found = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < scanLookups; ++i) {
+        int id = nextId();
+        for (const auto& s : all) {
+            if (s.ShipmentId == id) {
+                found += s.ItemId;
+                break;
             }
+        }
+    }
+    double scanNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / scanLookups;
 
-            switch (choice) {
-                case 1: {
-                    int itemId;
-                    string origin, destination, status;
-                    time_t expectedDelivery = time(nullptr) + (7 * 24 * 3600); // Default to a week from now
-
-                    cout << "Enter Item ID: ";
-                    cin >> itemId;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    cout << "Enter Origin: ";
-                    getline(cin, origin);
-                    cout << "Enter Destination: ";
-                    getline(cin, destination);
-                    cout << "Enter Status: ";
-                    getline(cin, status);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < indexedLookups; ++i) {
+        if (Shipment* s = shipmentRepo.trackShipment(nextId())) found += s->ItemId;
+    }
+    double indexNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / indexedLookups;
 
-                    Shipment newShipment(0, itemId, origin, destination, status, expectedDelivery);
-                    if (receiveShipment(newShipment)) {
-                        cout << "Shipment received successfully." << endl;
-                    } else {
-                        cout << "Failed to receive shipment." << endl;
-                    }
-                    break;
-                }
-                case 2:
-                    for (const auto& s : viewShipment()) {
-                        s.display();
-                    }
-                    break;
-                case 3: {
-                    int shipmentId;
-                    cout << "Enter Shipment ID to track: ";
-                    cin >> shipmentId;
-                    if (auto shipment = trackShipment(shipmentId)) {
-                        shipment->display();
-                    } else {
-                        cout << "Shipment with ID " << shipmentId << " not found." << endl;
-                    }
-                    break;
-                }
-                case 4: {
-                    int shipmentId, itemId;
-                    string origin, destination, status;
-                    time_t expectedDelivery = time(nullptr) + (7 * 24 * 3600);
+    cout << "Records: " << records << endl;
+    cout << "Linear scan: " << fixed << setprecision(1) << scanNs << " ns/lookup" << endl;
+    cout << "Hash index: " << indexNs << " ns/lookup" << endl;
+    cout << "Speedup: " << scanNs / indexNs << "x" << endl;
 
-                    cout << "Enter Shipment ID to dispatch: ";
-                    cin >> shipmentId;
-                    cout << "Enter Item ID: ";
-                    cin >> itemId;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    cout << "Enter Origin: ";
-                    getline(cin, origin);
-                    cout << "Enter Destination: ";
-                    getline(cin, destination);
-                    cout << "Enter Status: ";
-                    getline(cin, status);
+    for (int id = 2; id <= records; id += 2) {
+        Shipment delivered = *shipmentRepo.trackShipment(id);
+        delivered.Status = "delivered";
+        shipmentRepo.dispatchShipment(delivered);
+    }
+    start = chrono::steady_clock::now();
+    size_t expired = shipmentRepo.expireShipments("delivered");
+    double expireMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "Expired " << expired << " delivered shipments in " << expireMs << " ms" << endl;
+    cout << "(checksum " << found << ")" << endl;
+}
 
-                    Shipment updatedShipment(shipmentId, itemId, origin, destination, status, expectedDelivery);
-                    if (dispatchShipment(updatedShipment)) {
-                        cout << "Shipment dispatched successfully." << endl;
-                    } else {
-                        cout << "Failed to dispatch shipment." << endl;
-                    }
-                    break;
-                }
-                case 5: {
-                    int shipmentId;
-                    cout << "Enter Shipment ID to remove: ";
-                    cin >> shipmentId;
-                    if (removeShipment(shipmentId)) {
-                        cout << "Shipment removed successfully." << endl;
-                    } else {
-                        cout << "Shipment with ID " << shipmentId << " not found." << endl;
-                    }
-                    break;
+// --- Snapshot Benchmark ---
+// Writes `records` inventory items and shipments to a snapshot and times the restore.
+void runSnapshotBenchmark(int records) {
+    static const char* categories[] = {"Hardware", "Electrical", "Plumbing", "Packaging"};
+    static const char* cities[] = {"Chicago", "Dallas", "Newark", "Oakland", "Savannah"};
+    Warehouse source;
+    source.inventoryManager.reserve(records);
+    source.shipmentRepo.reserve(records);
+    for (int i = 0; i < records; ++i) {
+        source.inventoryManager.addInventory(Inventory(0, "Item " + to_string(i), categories[i % 4], i % 500, "Aisle " + to_string(i % 40)));
+        source.shipmentRepo.receiveShipment(Shipment(0, i + 1, cities[i % 5], cities[(i + 2) % 5], "in-transit", time(nullptr)));
+    }
+
+    const string path = "logistics_bench.snap";
+    auto start = chrono::steady_clock::now();
+    if (!SnapshotStore::save(source, path)) return;
+    double saveMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    Warehouse restored;
+    start = chrono::steady_clock::now();
+    bool loaded = SnapshotStore::load(restored, path);
+    double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    remove(path.c_str());
+    if (!loaded) return;
+
+    cout << "Records: " << records << " items + " << records << " shipments" << endl;
+    cout << "Save: " << fixed << setprecision(1) << saveMs << " ms" << endl;
+    cout << "Restore: " << loadMs << " ms" << endl;
+    cout << "Next item ID after restore: " << restored.inventoryManager.nextId() << endl;
+}
+
+// --- Journal Benchmark ---
+// Commits `records` journal records from 1 and 4 writer threads under group commit.
+void runJournalBenchmark(int records) {
+    const string path = "logistics_bench.journal";
+    for (int writers : {1, 4}) {
+        Journal journal;
+        if (!journal.open(path, 1, Durability::Group, chrono::milliseconds(10))) return;
+        Shipment shipment(0, 42, "Chicago", "Dallas", "in-transit", time(nullptr));
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (int w = 0; w < writers; ++w) {
+            threads.emplace_back([&journal, shipment, records, writers, w]() mutable {
+                for (int i = w; i < records; i += writers) {
+                    shipment.ShipmentId = i + 1;
+                    journal.log(JournalOp::ReceiveShipment, shipment);
                 }
-                case 0:
-                    cout << "Returning to Main Menu." << endl;
-                    break;
-                default:
-                    cout << "Invalid choice. Please try again." << endl;
+            });
+        }
+        for (auto& t : threads) t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << writers << " writer(s): " << fixed << setprecision(0) << records / seconds << " commits/s, "
+             << journal.syncs() << " fsyncs for " << records << " records" << endl;
+        journal.close();
+    }
+    remove(path.c_str());
+}
+
+// --- Change Stream Benchmark ---
+// Publishes `records` inventory changes from 1 and 4 writer threads: with no
+// subscriber, with a Block subscriber draining the ring, and with a Drop subscriber
+// that reads slowly. Reports the publish rate and what each subscriber received.
+void runChangeStreamBenchmark(int records) {
+    string payload(1, static_cast<char>(JournalOp::EditInventory));
+    ByteWriter encoder(payload);
+    Inventory(42, "Hex Bolt M8 x 40 Zinc", "Fasteners", 120, "Aisle 7").writeTo(encoder);
+    cout << "Event payload: " << payload.size() << " bytes" << endl;
+    for (const char* subscriber : {"none", "block", "drop"}) {
+        for (int writers : {1, 4}) {
+            ChangeStream stream;
+            int id = strcmp(subscriber, "none") == 0 ? -1
+                     : stream.subscribe(strcmp(subscriber, "block") == 0 ? Backpressure::Block : Backpressure::Drop);
+            atomic<bool> done{false};
+            long received = 0;
+            uint64_t skipped = 0;
+            thread reader;
+            if (id >= 0) {
+                reader = thread([&, id] {
+                    bool slow = strcmp(subscriber, "drop") == 0;
+                    while (true) {
+                        bool last = done.load();
+                        uint64_t cursor = stream.position(id);
+                        size_t count = stream.read(cursor, slow ? 16 : 1024, skipped, [&received](const ChangeEvent&) { received++; });
+                        stream.advance(id, cursor);
+                        if (count == 0 && last) break;
+                        if (slow) {
+                            this_thread::sleep_for(chrono::microseconds(100));
+                        } else if (count == 0) {
+                            stream.waitFor(cursor, chrono::milliseconds(1));
+                        }
+                    }
+                });
             }
-        } while (choice != 0);
+            auto start = chrono::steady_clock::now();
+            vector<thread> threads;
+            for (int w = 0; w < writers; ++w) {
+                threads.emplace_back([&stream, &payload, records, writers, w] {
+                    for (int i = w; i < records; i += writers) stream.publish(payload);
+                });
+            }
+            for (auto& t : threads) t.join();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            done = true;
+            if (reader.joinable()) reader.join();
+            ChangeStream::Stats stats = stream.stats();
+            cout << left << setw(6) << subscriber << right << writers << " writer(s): " << fixed << setprecision(0)
+                 << records / seconds << " events/s, " << setprecision(1) << seconds * 1e9 / records << " ns/event";
+            if (id >= 0) {
+                cout << ", received " << received << ", skipped " << skipped << " position(s), " << stats.Stalls << " stall(s), "
+                     << stats.Overruns << " overrun(s)";
+            }
+            cout << endl;
+        }
     }
-};
+}
 
-// --- Space Class ---
-class Space {
-public:
-    int SpaceId;
-    int TotalCapacity;
-    int UsedCapacity;
-    string Zone;
+// --- Columns Benchmark ---
+// Times the stock queries over `records` items with and without the columnar copy.
+void runColumnsBenchmark(int records) {
+    static const char* categories[] = {"Hardware", "Electrical", "Plumbing", "Packaging", "Safety", "Tools"};
+    InventoryManager inventoryManager;
+    inventoryManager.reserve(records);
+    time_t now = time(nullptr);
+    for (int i = 0; i < records; ++i) {
+        Inventory item(i + 1, "Item " + to_string(i), categories[i % 6], static_cast<int>((i * 2654435761u) % 1000),
+                       "Aisle " + to_string(i % 200));
+        item.LastUpdated = now - (i % 365) * 86400;
+        inventoryManager.restoreInventory(move(item));
+    }
 
-    Space(int spaceId = 0, int totalCapacity = 0, int usedCapacity = 0, string zone = "")
-        : SpaceId(spaceId), TotalCapacity(totalCapacity), UsedCapacity(usedCapacity), Zone(zone) {}
+    for (bool columnar : {false, true}) {
+        if (columnar) inventoryManager.enableColumns();
+        auto timed = [](auto&& run) {
+            auto start = chrono::steady_clock::now();
+            size_t result = run();
+            return make_pair(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(), result);
+        };
+        auto total = timed([&]() { return static_cast<size_t>(inventoryManager.totalQuantity()); });
+        auto byCategory = timed([&]() { return inventoryManager.quantityByCategory().size(); });
+        auto byLocation = timed([&]() { return inventoryManager.quantityByLocation().size(); });
+        auto lowStock = timed([&]() { return inventoryManager.lowStockItems(10).size(); });
+        auto stale = timed([&]() { return inventoryManager.staleItems(now - 300 * 86400).size(); });
+        cout << (columnar ? "Columnar" : "Row scan") << " (" << records << " items): " << fixed << setprecision(1)
+             << "total " << total.first << " ms (" << total.second << "), by category " << byCategory.first << " ms, by location "
+             << byLocation.first << " ms, low stock " << lowStock.first << " ms (" << lowStock.second << "), stale "
+             << stale.first << " ms (" << stale.second << ")" << endl;
+    }
+}
 
-    int getAvailableCapacity() const {
-        return TotalCapacity - UsedCapacity;
+// --- Query Benchmark ---
+// Compares an indexed attribute query against a full scan over `records` shipments.
+void runQueryBenchmark(int records) {
+    static const char* statuses[] = {"in-transit", "delivered", "pending", "delayed"};
+    ShipmentRepository shipmentRepo;
+    shipmentRepo.reserve(records);
+    for (int i = 0; i < records; ++i) {
+        string destination = "City " + to_string((i * 7919u) % 500);
+        shipmentRepo.receiveShipment(Shipment(0, i % 1000 + 1, "Origin", destination, statuses[i % 4], 0));
     }
+    const int queries = 100;
+    const optional<string> status = string("delayed");
+    size_t scanned = 0, indexed = 0;
 
-    void display() const {
-        cout << "Space ID: " << SpaceId << endl;
-        cout << "Total Capacity: " << TotalCapacity << endl;
-        cout << "Used Capacity: " << UsedCapacity << endl;
-        cout << "Available Capacity: " << getAvailableCapacity() << endl;
-        cout << "Zone: " << Zone << endl;
-        cout << "-------------------------" << endl;
+    auto start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) {
+        InternedString destination = "City " + to_string(q % 500);
+        for (const auto& s : shipmentRepo.viewShipment()) {
+            scanned += s.Status == *status && s.Destination == destination;
+        }
     }
-};
+    double scanMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / queries;
 
-// --- SpaceRepository Class ---
-class SpaceRepository {
-private:
-    vector<Space> spaces;
-    int nextSpaceId = 1;
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) {
+        indexed += shipmentRepo.findShipments(status, nullopt, "City " + to_string(q % 500), [](const Shipment&) {});
+    }
+    double indexMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / queries;
 
-public:
-    bool allocateSpace(Space space) {
-        space.SpaceId = nextSpaceId++;
-        spaces.push_back(space);
-        return true;
+    cout << "Records: " << records << ", status + destination, " << indexed / queries << " matches/query" << endl;
+    cout << "Full scan: " << fixed << setprecision(3) << scanMs << " ms/query" << endl;
+    cout << "Secondary indexes: " << indexMs << " ms/query" << endl;
+    if (scanned != indexed) cerr << "Query mismatch: " << scanned << " vs " << indexed << endl;
+}
+
+// --- Allocator Benchmark ---
+// Reserves and releases capacity across `records` bays and compares best fit with a scan.
+void runAllocatorBenchmark(int records) {
+    static const char* zones[] = {"North", "South", "East", "West", "Cold"};
+    SpaceRepository spaceRepo;
+    spaceRepo.reserve(records);
+    for (int i = 0; i < records; ++i) {
+        spaceRepo.allocateSpace(Space(0, 100 + static_cast<int>((i * 2654435761u) % 900), 0, zones[i % 5]));
     }
+    WarehouseGenerator gen;
 
-    bool freeSpace(int spaceId) {
-        auto it = remove_if(spaces.begin(), spaces.end(),
-                            [spaceId](const Space& sp){ return sp.SpaceId == spaceId; });
-        if (it != spaces.end()) {
-            spaces.erase(it, spaces.end());
-            return true;
+    const int operations = 200000;
+    vector<pair<int, int>> held;
+    held.reserve(operations);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < operations; ++i) {
+        int units = static_cast<int>(gen.next() % 200) + 1;
+        optional<string> zone;
+        if (i % 2) zone = zones[gen.next() % 5];
+        if (int spaceId = spaceRepo.reserveCapacity(units, zone)) held.emplace_back(spaceId, units);
+        if (held.size() > 1000 && gen.next() % 2) {
+            size_t victim = gen.next() % held.size();
+            spaceRepo.releaseCapacity(held[victim].first, held[victim].second);
+            held[victim] = held.back();
+            held.pop_back();
         }
-        return false;
     }
+    double opNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / operations;
 
-    bool updateSpace(Space space) {
-        for (auto& sp : spaces) {
-            if (sp.SpaceId == space.SpaceId) {
-                sp.TotalCapacity = space.TotalCapacity;
-                sp.UsedCapacity = space.UsedCapacity;
-                sp.Zone = space.Zone;
-                return true;
+    const int scans = 200;
+    long long checksum = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < scans; ++i) {
+        int units = static_cast<int>(gen.next() % 200) + 1;
+        const Space* best = nullptr;
+        for (const auto& sp : spaceRepo.viewSpaceUsage()) {
+            int available = sp.getAvailableCapacity();
+            if (available >= units && (!best || available < best->getAvailableCapacity())) best = &sp;
+        }
+        if (best) checksum += best->SpaceId;
+    }
+    double scanNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / scans;
+
+    cout << "Bays: " << records << ", " << held.size() << " reservations held" << endl;
+    cout << "Best-fit reserve/release: " << fixed << setprecision(1) << opNs << " ns/op" << endl;
+    cout << "Linear best-fit scan: " << scanNs << " ns/op (checksum " << checksum << ")" << endl;
+}
+
+// --- Snapshot Read Benchmark ---
+// Runs a writer moving stock between items while a reader sums all `records` items,
+// once with the reader holding the lock for its scan and once scanning a pinned version.
+void runMvccBenchmark(int records) {
+    InventoryManager inventoryManager;
+    inventoryManager.reserve(records);
+    for (int i = 0; i < records; ++i) {
+        inventoryManager.addInventory(Inventory(0, "Item " + to_string(i), "Hardware", 100, "Aisle 1"));
+    }
+    inventoryManager.enableVersions();
+    const long long expected = 100ll * records;
+
+    for (bool pinned : {false, true}) {
+        shared_mutex lock;
+        atomic<bool> done{false};
+        long long edits = 0;
+        double worstWaitUs = 0;
+        thread writer([&]() {
+            WarehouseGenerator gen;
+            while (!done) {
+                int from = gen.pick(records);
+                int to = gen.pick(records);
+                if (from == to) continue;
+                auto begin = chrono::steady_clock::now();
+                unique_lock<shared_mutex> guard(lock);
+                worstWaitUs = max(worstWaitUs, chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count());
+                Inventory a = *inventoryManager.searchInventory(from);
+                Inventory b = *inventoryManager.searchInventory(to);
+                a.Quantity--;
+                b.Quantity++;
+                inventoryManager.editInventory(a);
+                inventoryManager.editInventory(b);
+                edits += 2;
             }
+        });
+
+        int scans = 0, inconsistent = 0;
+        auto start = chrono::steady_clock::now();
+        while (chrono::steady_clock::now() - start < chrono::seconds(1)) {
+            long long total = 0;
+            if (pinned) {
+                VersionedRecords<Inventory>::Snapshot snapshot;
+                {
+                    shared_lock<shared_mutex> guard(lock);
+                    snapshot = inventoryManager.snapshot();
+                }
+                snapshot.forEach([&total](const Inventory& item) { total += item.Quantity; });
+            } else {
+                shared_lock<shared_mutex> guard(lock);
+                for (const auto& item : inventoryManager.records()) total += item.Quantity;
+            }
+            scans++;
+            inconsistent += total != expected;
         }
-        return false;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        done = true;
+        writer.join();
+
+        cout << (pinned ? "Pinned version: " : "Locked scan:    ") << scans << " scans, " << fixed << setprecision(0)
+             << edits / seconds << " edits/s, worst writer wait " << setprecision(1) << worstWaitUs / 1000 << " ms";
+        if (inconsistent) cout << ", " << inconsistent << " inconsistent total(s)";
+        cout << endl;
     }
+}
 
-    Space* searchSpace(int id) {
-        for (auto& sp : spaces) {
-            if (sp.SpaceId == id) {
-                return &sp;
+// --- Manifest Benchmark ---
+// Receives a `lines`-line truck manifest with group commit, first as three journaled
+// operations per line (shipment, item quantity, space usage), then as one batch.
+void runManifestBenchmark(int lines) {
+    const string path = "logistics_bench.journal";
+    const int items = 1000;
+    const int bays = 100;
+    for (bool batched : {false, true}) {
+        Warehouse warehouse;
+        for (int i = 0; i < items; ++i) warehouse.inventoryManager.addInventory(Inventory(0, "Item " + to_string(i), "Hardware", 0, "Dock"));
+        for (int i = 0; i < bays; ++i) warehouse.spaceRepo.allocateSpace(Space(0, 1 << 30, 0, "Dock"));
+        Journal journal;
+        if (!journal.open(path, 1, Durability::Group, chrono::milliseconds(10))) return;
+        warehouse.attachJournal(&journal);
+        uint64_t syncsBefore = journal.syncs();
+
+        auto start = chrono::steady_clock::now();
+        if (batched) {
+            WarehouseBatch batch;
+            for (int i = 0; i < lines; ++i) {
+                batch.receive(Shipment(0, i % items + 1, "Chicago", "Dock", "received", time(nullptr)), 10, i % bays + 1);
+            }
+            string error;
+            if (!warehouse.applyBatch(batch, error)) cerr << "Batch rejected, " << error << endl;
+        } else {
+            for (int i = 0; i < lines; ++i) {
+                warehouse.shipmentRepo.receiveShipment(Shipment(0, i % items + 1, "Chicago", "Dock", "received", time(nullptr)));
+                Inventory item = *warehouse.inventoryManager.searchInventory(i % items + 1);
+                item.Quantity += 10;
+                warehouse.inventoryManager.editInventory(move(item));
+                Space space = *warehouse.spaceRepo.searchSpace(i % bays + 1);
+                space.UsedCapacity += 10;
+                warehouse.spaceRepo.updateSpace(move(space));
             }
         }
-        return nullptr;
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << (batched ? "One batch:      " : "Per-line ops:   ") << lines << " lines in " << fixed << setprecision(1) << ms
+             << " ms, " << journal.syncs() - syncsBefore << " fsyncs, " << journal.size() << " journal bytes" << endl;
+        journal.close();
     }
+    remove(path.c_str());
+}
 
-    vector<Space> viewSpaceUsage() const {
-        return spaces;
+// --- Render Benchmark ---
+// Renders `records` shipments in every format to a null sink and times timestamp formatting.
+// Forwards to another stream buffer while counting the bytes written through it.
+struct CountingBuffer : streambuf {
+    streambuf* target;
+    size_t bytes = 0;
+
+    explicit CountingBuffer(streambuf* t) : target(t) {}
+
+    streamsize xsputn(const char* data, streamsize n) override {
+        bytes += static_cast<size_t>(n);
+        return target->sputn(data, n);
     }
 
-    void spaceSubMenu() {
-        int choice;
-        do {
-            cout << "\n--- Space Management ---" << endl;
-            cout << "1. Allocate Space" << endl;
-            cout << "2. View Space Usage" << endl;
-            cout << "3. Search Space" << endl;
-            cout << "4. Update Space" << endl;
-            cout << "5. Free Space" << endl;
-            cout << "0. Back to Main Menu" << endl;
-            cout << "Enter your choice: ";
-            cin >> choice;
+    int overflow(int c) override {
+        if (c == EOF) return 0;
+        ++bytes;
+        return target->sputc(static_cast<char>(c));
+    }
 
-            if (cin.fail()) {
-                cerr << "Invalid input. Please enter a number." << endl;
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                choice = -1;
-                continue;
+    int sync() override {
+        return target->pubsync();
+    }
+};
+
+void runRenderBenchmark(int records) {
+    static const char* cities[] = {"Chicago", "Dallas", "Newark", "Oakland", "Savannah"};
+    ShipmentRepository shipmentRepo;
+    shipmentRepo.reserve(records);
+    time_t now = time(nullptr);
+    for (int i = 0; i < records; ++i) {
+        shipmentRepo.receiveShipment(Shipment(0, i % 1000 + 1, cities[i % 5], cities[(i + 2) % 5], "in-transit", now + i));
+    }
+
+    ofstream sink("/dev/null", ios::binary);
+    const pair<const char*, RenderFormat> formats[] = {
+        {"human", RenderFormat::Human}, {"jsonl", RenderFormat::JsonLines}, {"tsv", RenderFormat::Tsv}};
+    for (const auto& format : formats) {
+        CountingBuffer counter(sink.rdbuf());
+        ostream out(&counter);
+        auto start = chrono::steady_clock::now();
+        {
+            RecordWriter writer(out, format.second);
+            for (const auto& s : shipmentRepo.viewShipment()) {
+                s.render(writer);
             }
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << format.first << ": " << fixed << setprecision(0) << records / seconds << " records/s, "
+             << setprecision(1) << counter.bytes / seconds / (1 << 20) << " MiB/s" << endl;
+    }
+    char text[TimestampFormatter::Length];
+    size_t checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < records; ++i) {
+        TimestampFormatter::format(now + i * 7, text);
+        checksum += static_cast<unsigned char>(text[18]);
+    }
+    double tsMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "Formatted " << records << " timestamps in " << setprecision(1) << tsMs << " ms (checksum " << checksum << ")" << endl;
+}
 
-            switch (choice) {
-                case 1: {
-                    int totalCapacity, usedCapacity;
-                    string zone;
-                    cout << "Enter Total Capacity: ";
-                    cin >> totalCapacity;
-                    cout << "Enter Used Capacity: ";
-                    cin >> usedCapacity;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    cout << "Enter Zone: ";
-                    getline(cin, zone);
-                    Space newSpace(0, totalCapacity, usedCapacity, zone);
-                    if (allocateSpace(newSpace)) {
-                        cout << "Space allocated successfully." << endl;
-                    } else {
-                        cout << "Failed to allocate space." << endl;
-                    }
-                    break;
-                }
-                case 2:
-                    for (const auto& sp : viewSpaceUsage()) {
-                        sp.display();
-                    }
-                    break;
-                case 3: {
-                    int spaceId;
-                    cout << "Enter Space ID to search: ";
-                    cin >> spaceId;
-                    if (auto space = searchSpace(spaceId)) {
-                        space->display();
-                    } else {
-                        cout << "Space with ID " << spaceId << " not found." << endl;
-                    }
-                    break;
-                }
-                case 4: {
-                    int spaceId, totalCapacity, usedCapacity;
-                    string zone;
-                    cout << "Enter Space ID to update: ";
-                    cin >> spaceId;
-                    cout << "Enter new Total Capacity: ";
-                    cin >> totalCapacity;
-                    cout << "Enter new Used Capacity: ";
-                    cin >> usedCapacity;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    cout << "Enter new Zone: ";
-                    getline(cin, zone);
-                    Space updatedSpace(spaceId, totalCapacity, usedCapacity, zone);
-                    if (updateSpace(updatedSpace)) {
-                        cout << "Space updated successfully." << endl;
-                    } else {
-                        cout << "Failed to update space." << endl;
+// --- Benchmark Suite ---
+// Peak resident set size of the process so far, in KiB.
+long long peakRssKb() {
+#ifndef _WIN32
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+    return 0;
+}
+
+// Times `count` calls of fn(i) one by one and writes ops/s, latency percentiles, the
+// allocations made through `counter` and peak RSS as one record.
+template <typename Fn>
+void timeOperation(RecordWriter& out, const CountingResource& counter, int scale, const char* repository, const char* operation,
+                   int count, Fn fn) {
+    vector<uint32_t> nanos(static_cast<size_t>(count));
+    uint64_t allocationsBefore = counter.allocationCount();
+    uint64_t bytesBefore = counter.allocatedBytes();
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        auto begin = chrono::steady_clock::now();
+        fn(i);
+        auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
+        nanos[static_cast<size_t>(i)] = static_cast<uint32_t>(min<long long>(ns, numeric_limits<uint32_t>::max()));
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    uint64_t allocations = counter.allocationCount() - allocationsBefore;
+    uint64_t allocatedBytes = counter.allocatedBytes() - bytesBefore;
+    sort(nanos.begin(), nanos.end());
+    auto percentile = [&nanos](double p) {
+        return static_cast<long long>(nanos[min(nanos.size() - 1, static_cast<size_t>(p * nanos.size()))]);
+    };
+    out.beginRecord("benchmark");
+    out.field("Scale", "Scale", scale);
+    out.field("Repository", "Repository", string(repository));
+    out.field("Operation", "Operation", string(operation));
+    out.field("Operations", "Ops", count);
+    out.field("Ops/s", "OpsPerSec", static_cast<long long>(count / max(seconds, 1e-9)));
+    out.field("p50 ns", "P50Ns", percentile(0.50));
+    out.field("p90 ns", "P90Ns", percentile(0.90));
+    out.field("p99 ns", "P99Ns", percentile(0.99));
+    out.field("p99.9 ns", "P999Ns", percentile(0.999));
+    out.field("Max ns", "MaxNs", static_cast<long long>(nanos.back()));
+    out.field("Allocations", "Allocations", static_cast<long long>(allocations));
+    out.field("Allocated bytes", "AllocatedBytes", static_cast<long long>(allocatedBytes));
+    out.field("Peak RSS KiB", "PeakRssKb", peakRssKb());
+    out.endRecord();
+    out.flush();
+}
+
+// Runs every public repository operation and two mixed workloads at each scale,
+// writing one JSON line per operation to stdout. A scale of N populates N inventory
+// items and shipments, N/10 spaces and maintenance schedules, and N/100 reports.
+// Each operation is timed over up to 100000 calls (view-all over 5 full passes);
+// records added during a run are deleted again, so every scale keeps its size.
+// Repositories allocate from a pool; a bulk load of up to 1M shipments is also run on
+// the plain heap and on a monotonic arena for comparison. Allocations count what
+// the repositories request from their memory resource. Peak RSS is for the whole process.
+void runBenchmarkSuite(const vector<int>& scales) {
+    RecordWriter out(cout, RenderFormat::JsonLines);
+    long long checksum = 0;
+    for (int scale : scales) {
+        const int bulk = min(scale, 1000000);
+        for (const char* backing : {"heap", "pool", "arena"}) {
+            pmr::unsynchronized_pool_resource pool;
+            pmr::monotonic_buffer_resource arena;
+            pmr::memory_resource* upstream = pmr::new_delete_resource();
+            if (backing == string("pool")) upstream = &pool;
+            if (backing == string("arena")) upstream = &arena;
+            CountingResource counter(upstream);
+            WarehouseGenerator gen;
+            ShipmentRepository scratch(&counter);
+            scratch.reserve(bulk);
+            string name = string("bulk-load-") + backing;
+            timeOperation(out, counter, scale, "shipments", name.c_str(), bulk, [&](int) { scratch.receiveShipment(gen.shipment(scale)); });
+        }
+
+        pmr::unsynchronized_pool_resource pool;
+        CountingResource counter(&pool);
+        Warehouse warehouse(&counter);
+        WarehouseGenerator gen;
+        InventoryManager& inventory = warehouse.inventoryManager;
+        ShipmentRepository& shipments = warehouse.shipmentRepo;
+        SpaceRepository& spaces = warehouse.spaceRepo;
+        MaintenanceRepository& maintenance = warehouse.maintenanceRepo;
+        ReportRepository& reports = warehouse.reportRepo;
+
+        const int ops = min(scale, 100000);
+        const int passes = 5;
+        const int items = scale;
+        const int bays = scale / 10;
+        const int schedules = scale / 10;
+        cerr << "Populating " << scale << " records..." << endl;
+        inventory.reserve(items);
+        shipments.reserve(scale);
+        spaces.reserve(bays);
+        maintenance.reserve(schedules);
+        reports.reserve(scale / 100);
+        timeOperation(out, counter, scale, "inventory", "populate", items, [&](int) { inventory.addInventory(gen.item()); });
+        timeOperation(out, counter, scale, "shipments", "populate", scale, [&](int) { shipments.receiveShipment(gen.shipment(items)); });
+        if (bays > 0) {
+            timeOperation(out, counter, scale, "spaces", "populate", bays, [&](int) { spaces.allocateSpace(gen.space()); });
+            timeOperation(out, counter, scale, "maintenance", "populate", schedules, [&](int) { maintenance.scheduleMaintenance(gen.maintenance()); });
+        }
+        if (scale >= 100) {
+            timeOperation(out, counter, scale, "reports", "populate", scale / 100, [&](int) { reports.generateReport(gen.report()); });
+        }
+
+        int firstAdded = inventory.nextId();
+        timeOperation(out, counter, scale, "inventory", "add", ops, [&](int) { inventory.addInventory(gen.item()); });
+        timeOperation(out, counter, scale, "inventory", "search", ops, [&](int) {
+            if (const Inventory* item = static_cast<const InventoryManager&>(inventory).searchInventory(gen.pick(items))) checksum += item->Quantity;
+        });
+        timeOperation(out, counter, scale, "inventory", "edit", ops, [&](int) {
+            Inventory item = *inventory.searchInventory(gen.pick(items));
+            item.Quantity = static_cast<int>(gen.next() % 500);
+            inventory.editInventory(move(item));
+        });
+        timeOperation(out, counter, scale, "inventory", "delete", ops, [&](int i) { inventory.deleteInventory(firstAdded + i); });
+        timeOperation(out, counter, scale, "inventory", "view-all", passes, [&](int) {
+            for (const auto& item : inventory.records()) checksum += item.Quantity;
+        });
+
+        firstAdded = shipments.nextId();
+        timeOperation(out, counter, scale, "shipments", "receive", ops, [&](int) { shipments.receiveShipment(gen.shipment(items)); });
+        timeOperation(out, counter, scale, "shipments", "track", ops, [&](int) {
+            if (const Shipment* s = static_cast<const ShipmentRepository&>(shipments).trackShipment(gen.pick(scale))) checksum += s->ItemId;
+        });
+        timeOperation(out, counter, scale, "shipments", "dispatch", ops, [&](int) {
+            Shipment s = *shipments.trackShipment(gen.pick(scale));
+            s.Status = "in-transit";
+            s.ExpectedDelivery += 86400;
+            shipments.dispatchShipment(move(s));
+        });
+        timeOperation(out, counter, scale, "shipments", "remove", ops, [&](int i) { shipments.removeShipment(firstAdded + i); });
+        timeOperation(out, counter, scale, "shipments", "view-all", passes, [&](int) {
+            for (const auto& s : shipments.viewShipment()) checksum += s.ItemId;
+        });
+        timeOperation(out, counter, scale, "shipments", "join-items", passes, [&](int) {
+            shipments.joinItems([&](const Shipment&, const Inventory* item) {
+                if (item) checksum += item->Quantity;
+            });
+        });
+        timeOperation(out, counter, scale, "shipments", "join-by-id", passes, [&](int) {
+            const InventoryManager& catalog = inventory;
+            for (const auto& s : shipments.viewShipment()) {
+                if (const Inventory* item = catalog.searchInventory(s.ItemId)) checksum += item->Quantity;
+            }
+        });
+
+        if (bays > 0) {
+            int bayOps = min(ops, bays);
+            firstAdded = spaces.nextId();
+            timeOperation(out, counter, scale, "spaces", "allocate", bayOps, [&](int) { spaces.allocateSpace(gen.space()); });
+            timeOperation(out, counter, scale, "spaces", "search", bayOps, [&](int) {
+                if (const Space* sp = static_cast<const SpaceRepository&>(spaces).searchSpace(gen.pick(bays))) checksum += sp->UsedCapacity;
+            });
+            timeOperation(out, counter, scale, "spaces", "update", bayOps, [&](int) {
+                Space sp = *spaces.searchSpace(gen.pick(bays));
+                sp.UsedCapacity = static_cast<int>(gen.next() % static_cast<uint64_t>(sp.TotalCapacity + 1));
+                spaces.updateSpace(move(sp));
+            });
+            timeOperation(out, counter, scale, "spaces", "reserve", bayOps, [&](int) {
+                checksum += spaces.reserveCapacity(static_cast<int>(gen.next() % 50) + 1);
+            });
+            timeOperation(out, counter, scale, "spaces", "free", bayOps, [&](int i) { spaces.freeSpace(firstAdded + i); });
+            timeOperation(out, counter, scale, "spaces", "view-all", passes, [&](int) {
+                for (const auto& sp : spaces.viewSpaceUsage()) checksum += sp.UsedCapacity;
+            });
+
+            firstAdded = maintenance.nextId();
+            timeOperation(out, counter, scale, "maintenance", "schedule", bayOps, [&](int) { maintenance.scheduleMaintenance(gen.maintenance()); });
+            timeOperation(out, counter, scale, "maintenance", "view", bayOps, [&](int) {
+                if (const Maintenance* m = static_cast<const MaintenanceRepository&>(maintenance).viewSchedule(gen.pick(schedules))) checksum += m->EquipmentId;
+            });
+            timeOperation(out, counter, scale, "maintenance", "update", bayOps, [&](int) {
+                Maintenance m = *maintenance.viewSchedule(gen.pick(schedules));
+                m.ScheduledDate += 86400;
+                maintenance.updateSchedule(move(m));
+            });
+            timeOperation(out, counter, scale, "maintenance", "remove", bayOps, [&](int i) { maintenance.removeMaintenance(firstAdded + i); });
+            timeOperation(out, counter, scale, "maintenance", "view-all", passes, [&](int) {
+                for (const auto& m : maintenance.viewAll()) checksum += m.EquipmentId;
+            });
+        }
+
+        if (scale >= 100) {
+            int reportOps = min(ops, scale / 100);
+            timeOperation(out, counter, scale, "reports", "generate", reportOps, [&](int) { reports.generateReport(gen.report()); });
+            int reportCount = reports.nextId() - 1;
+            timeOperation(out, counter, scale, "reports", "download", reportOps, [&](int) {
+                if (optional<Report> r = reports.downloadReport(gen.pick(reportCount))) checksum += r->ReportId;
+            });
+            timeOperation(out, counter, scale, "reports", "view-all", passes, [&](int) {
+                for (const auto& r : reports.viewReports()) checksum += r.ReportId;
+            });
+        }
+
+        // Lookups and updates spread over inventory and shipments.
+        for (int writePercent : {10, 50}) {
+            string name = "mixed-" + to_string(100 - writePercent) + "/" + to_string(writePercent);
+            timeOperation(out, counter, scale, "warehouse", name.c_str(), ops, [&](int) {
+                uint64_t r = gen.next();
+                bool write = static_cast<int>(r % 100) < writePercent;
+                if (r & 0x100) {
+                    Inventory* item = inventory.searchInventory(gen.pick(items));
+                    if (!write) {
+                        checksum += item->Quantity;
+                        return;
                     }
-                    break;
-                }
-                case 5: {
-                    int spaceId;
-                    cout << "Enter Space ID to free: ";
-                    cin >> spaceId;
-                    if (freeSpace(spaceId)) {
-                        cout << "Space freed successfully." << endl;
-                    } else {
-                        cout << "Space with ID " << spaceId << " not found." << endl;
+                    Inventory edited = *item;
+                    edited.Quantity = static_cast<int>(r % 500);
+                    inventory.editInventory(move(edited));
+                } else {
+                    Shipment* s = shipments.trackShipment(gen.pick(scale));
+                    if (!write) {
+                        checksum += s->ItemId;
+                        return;
                     }
-                    break;
+                    Shipment dispatched = *s;
+                    dispatched.ExpectedDelivery += 3600;
+                    shipments.dispatchShipment(move(dispatched));
                 }
-                case 0:
-                    cout << "Returning to Main Menu." << endl;
-                    break;
-                default:
-                    cout << "Invalid choice. Please try again." << endl;
-            }
-        } while (choice != 0);
+            });
+        }
     }
-};
+    cerr << "Done (checksum " << checksum << ")." << endl;
+}
 
-int main() {
+// --- Name Search Benchmark ---
+// Builds a catalog of `records` generated product names and times prefix, substring
+// and fuzzy lookups through the name index, with a full scan for comparison.
+void runNameSearchBenchmark(int records) {
+    static const char* kinds[] = {"Hex", "Carriage", "Flange", "Socket", "Lag", "Wing", "Anchor", "Machine", "Thumb", "Eye"};
+    static const char* parts[] = {"Bolt", "Nut", "Washer", "Screw", "Bracket", "Hinge", "Clamp", "Valve", "Fitting", "Coupling",
+                                  "Cable", "Conduit", "Gasket", "Spring", "Rivet", "Pin", "Hook", "Strap", "Glove", "Tape"};
+    static const char* finishes[] = {"Zinc", "Stainless", "Brass", "Galvanized", "Nylon", "Black Oxide", "Chrome", "Copper"};
     InventoryManager inventoryManager;
-    MaintenanceRepository maintenanceRepo;
-    ReportRepository reportRepo;
-    ShipmentRepository shipmentRepo;
-    SpaceRepository spaceRepo;
+    inventoryManager.reserve(records);
+    WarehouseGenerator gen;
+    vector<string> names;
+    names.reserve(records);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < records; ++i) {
+        uint64_t r = gen.next();
+        string name = string(kinds[r % 10]) + " " + parts[(r >> 8) % 20] + " M" + to_string(3 + (r >> 16) % 22) + " x " +
+                      to_string(10 + 5 * ((r >> 24) % 40)) + " " + finishes[(r >> 32) % 8] + " R" +
+                      to_string(10000 + (r >> 40) % 200000);
+        inventoryManager.addInventory(Inventory(0, name, "Hardware", 1, "Aisle 1"));
+        names.push_back(move(name));
+    }
+    inventoryManager.nameIndex();
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    // Queries are cut from the names of random items; fuzzy ones swap two letters of a word.
+    const int queries = 2000;
+    auto measure = [&](const char* label, NameMatch mode, auto makeQuery) {
+        WarehouseGenerator picks(12345);
+        vector<double> latencies;
+        size_t found = 0;
+        for (int q = 0; q < queries; ++q) {
+            string query = makeQuery(names[picks.pick(records) - 1], picks.next());
+            auto begin = chrono::steady_clock::now();
+            found += inventoryManager.searchByName(query, mode, 10).size();
+            latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count());
+        }
+        sort(latencies.begin(), latencies.end());
+        double total = 0;
+        for (double l : latencies) total += l;
+        cout << left << setw(10) << label << right << fixed << setprecision(1) << " mean " << setw(7) << total / queries
+             << " us, p50 " << setw(7) << latencies[queries / 2] << " us, p99 " << setw(7) << latencies[queries * 99 / 100]
+             << " us, " << setprecision(2) << static_cast<double>(found) / queries << " hits/query" << endl;
+    };
+    cout << "Records: " << records << ", vocabulary " << inventoryManager.nameIndex().vocabularySize() << " words, index "
+         << inventoryManager.nameIndex().bytesUsed() / (1024 * 1024) << " MiB, built in " << fixed << setprecision(0)
+         << buildMs << " ms" << endl;
+    measure("prefix", NameMatch::Prefix, [](const string& name, uint64_t r) {
+        size_t second = name.find(' ') + 1;
+        return name.substr(0, second + 1 + r % 3);
+    });
+    measure("code", NameMatch::Prefix, [](const string& name, uint64_t) {
+        return name.substr(0, name.rfind(' ') + 5);
+    });
+    measure("substring", NameMatch::Substring, [](const string& name, uint64_t r) {
+        size_t from = name.find(' ') + 1 + r % 3;
+        return name.substr(from, 8 + (r >> 8) % 6);
+    });
+    measure("fuzzy", NameMatch::Fuzzy, [](const string& name, uint64_t r) {
+        string query = name.substr(0, name.find(" x "));
+        size_t at = query.find(' ') + 2 + r % 2;
+        swap(query[at], query[at + 1]);
+        return query + name.substr(name.rfind(' '));
+    });
+
+    const string query = "bolt m8 x 4";
+    size_t indexed = inventoryManager.searchByName(query, NameMatch::Substring, records).size();
+    start = chrono::steady_clock::now();
+    size_t scanned = 0;
+    string normalized;
+    for (const auto& item : inventoryManager.records()) {
+        NameIndex::normalize(item.ItemName.str(), normalized);
+        scanned += normalized.find(query) != string::npos;
+    }
+    double scanMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "Full scan for \"" << query << "\": " << fixed << setprecision(1) << scanMs << " ms, " << scanned << " matches" << endl;
+    if (scanned != indexed) cerr << "Search mismatch: " << scanned << " vs " << indexed << endl;
+}
+
+// --- Command-line Options ---
+struct AppOptions {
+    string snapshotPath = "logistics.snap";
+    string journalPath = "logistics.journal";
+    Durability durability = Durability::Group;
+    chrono::milliseconds syncInterval{10};
+    uint64_t compactBytes = 64ull << 20;
+    string importKind;
+    string importPath;
+    string rejectPath;
+    string exportKind;
+    bool columnar = false;
+    RenderFormat exportFormat = RenderFormat::Human;
+    string servePath;
+    int workers = static_cast<int>(max(2u, thread::hardware_concurrency()));
+    string changesPath;
+    bool changesToSocket = false;
+    string loadgenPath;
+    int clients = 8;
+    int requests = 10000;
+    int writePercent = 10;
+};
+
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--snapshot <file>] [--journal <file>]"
+         << " [--durability none|group|interval] [--sync-interval <ms>] [--compact-bytes <n>] [--columnar]" << endl;
+    cerr << "       " << program << " [options] --import inventory|shipments|spaces|manifest <file.csv|file.jsonl> [--reject <file>]" << endl;
+    cerr << "       " << program << " [options] --export inventory|maintenance|reports|shipments|spaces [--format human|jsonl|tsv]" << endl;
+    cerr << "       " << program << " [options] --serve <socket> [--workers <n>]" << endl;
+    cerr << "       " << program << " [options] --changes <file> | --changes-socket <socket>   (stream every change)" << endl;
+    cerr << "       " << program << " --loadgen <socket> [--clients <n>] [--requests <n per client>] [--writes <percent>]" << endl;
+    cerr << "       " << program << " --bench [lookup|snapshot|journal|changes|render|columns|query|names|allocator|mvcc|manifest] [records]" << endl;
+    cerr << "       " << program << " --bench suite [records]   (JSON lines; default scales 10000, 1000000, 10000000)" << endl;
+}
+
+// Writes a final snapshot that includes every journal record, then retires the journal.
+bool checkpoint(Warehouse& warehouse, Journal& journal, JournalCompactor& compactor, const AppOptions& options) {
+    compactor.stop();
+    if (!SnapshotStore::save(warehouse, options.snapshotPath, journal.epoch())) return false;
+    journal.close();
+    remove(options.journalPath.c_str());
+    return true;
+}
+
+// Writes every record of one repository to stdout in the requested format.
+bool exportRecords(const Warehouse& warehouse, const string& kind, RenderFormat format) {
+    RecordWriter out(cout, format);
+    if (kind == "inventory") {
+        for (const auto& item : warehouse.inventoryManager.records()) item.render(out);
+    } else if (kind == "maintenance") {
+        for (const auto& m : warehouse.maintenanceRepo.records()) m.render(out);
+    } else if (kind == "reports") {
+        for (const auto& r : warehouse.reportRepo.records()) r.render(out);
+    } else if (kind == "shipments") {
+        for (const auto& s : warehouse.shipmentRepo.records()) s.render(out);
+    } else if (kind == "spaces") {
+        for (const auto& sp : warehouse.spaceRepo.records()) sp.render(out);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+volatile sig_atomic_t shutdownRequested = 0;
+
+void requestShutdown(int) {
+    shutdownRequested = 1;
+}
+
+// Serves clients until SIGINT or SIGTERM, then drains the workers and checkpoints.
+bool serveWarehouse(Warehouse& warehouse, Journal& journal, JournalCompactor& compactor, const AppOptions& options) {
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, requestShutdown);
+    signal(SIGTERM, requestShutdown);
+    WarehouseServer server(warehouse, &journal);
+    if (!server.start(options.servePath, options.workers)) return false;
+    cerr << "Serving on " << options.servePath << " with " << options.workers << " worker(s)." << endl;
+    while (!shutdownRequested) this_thread::sleep_for(chrono::milliseconds(100));
+    server.stop();
+    cerr << "Shutting down." << endl;
+    return checkpoint(warehouse, journal, compactor, options);
+}
+#endif
+
+// Loads the latest snapshot, replays any journals written after it, and folds the
+// result back into a fresh snapshot so the new journal starts empty.
+bool recoverWarehouse(Warehouse& warehouse, const AppOptions& options, uint64_t& epoch) {
+    epoch = 0;
+    if (ifstream(options.snapshotPath).good() && !SnapshotStore::load(warehouse, options.snapshotPath, &epoch)) {
+        return false;
+    }
+    uint64_t snapshotEpoch = epoch;
+    size_t applied = 0;
+    for (const string& path : {JournalCompactor::sealedPath(options.journalPath), options.journalPath}) {
+        if (!ifstream(path).good()) continue;
+        uint64_t journalEpoch = 0;
+        if (!JournalReplay::replay(warehouse, path, snapshotEpoch, journalEpoch, applied)) return false;
+        epoch = max(epoch, journalEpoch);
+    }
+    if (applied > 0) {
+        cerr << "Recovered " << applied << " journal record(s)." << endl;
+        if (!SnapshotStore::save(warehouse, options.snapshotPath, epoch)) return false;
+    }
+    remove(JournalCompactor::sealedPath(options.journalPath).c_str());
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    AppOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--bench") {
+            string kind = hasValue && !isdigit(static_cast<unsigned char>(argv[i + 1][0])) ? argv[++i] : "lookup";
+            bool hasRecords = i + 1 < argc;
+            int records = hasRecords ? atoi(argv[i + 1]) : 1000000;
+            if (kind == "snapshot") {
+                runSnapshotBenchmark(records);
+            } else if (kind == "journal") {
+                runJournalBenchmark(records);
+            } else if (kind == "changes") {
+                runChangeStreamBenchmark(records);
+            } else if (kind == "render") {
+                runRenderBenchmark(records);
+            } else if (kind == "columns") {
+                runColumnsBenchmark(records);
+            } else if (kind == "query") {
+                runQueryBenchmark(records);
+            } else if (kind == "names") {
+                runNameSearchBenchmark(records);
+            } else if (kind == "allocator") {
+                runAllocatorBenchmark(records);
+            } else if (kind == "mvcc") {
+                runMvccBenchmark(records);
+            } else if (kind == "manifest") {
+                runManifestBenchmark(hasRecords ? records : 5000);
+            } else if (kind == "suite") {
+                runBenchmarkSuite(hasRecords ? vector<int>{records} : vector<int>{10000, 1000000, 10000000});
+            } else {
+                runLookupBenchmark(records);
+            }
+            return 0;
+        } else if (arg == "--snapshot" && hasValue) {
+            options.snapshotPath = argv[++i];
+        } else if (arg == "--journal" && hasValue) {
+            options.journalPath = argv[++i];
+        } else if (arg == "--durability" && hasValue) {
+            string mode = argv[++i];
+            if (mode == "none") {
+                options.durability = Durability::None;
+            } else if (mode == "group") {
+                options.durability = Durability::Group;
+            } else if (mode == "interval") {
+                options.durability = Durability::Interval;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--sync-interval" && hasValue) {
+            options.syncInterval = chrono::milliseconds(max(1, atoi(argv[++i])));
+        } else if (arg == "--compact-bytes" && hasValue) {
+            options.compactBytes = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--import" && i + 2 < argc) {
+            options.importKind = argv[++i];
+            options.importPath = argv[++i];
+        } else if (arg == "--reject" && hasValue) {
+            options.rejectPath = argv[++i];
+        } else if (arg == "--columnar") {
+            options.columnar = true;
+        } else if (arg == "--export" && hasValue) {
+            options.exportKind = argv[++i];
+        } else if (arg == "--format" && hasValue) {
+            if (!RecordWriter::parseFormat(argv[++i], options.exportFormat)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--serve" && hasValue) {
+            options.servePath = argv[++i];
+        } else if (arg == "--changes" && hasValue) {
+            options.changesPath = argv[++i];
+            options.changesToSocket = false;
+        } else if (arg == "--changes-socket" && hasValue) {
+            options.changesPath = argv[++i];
+            options.changesToSocket = true;
+        } else if (arg == "--workers" && hasValue) {
+            options.workers = max(1, atoi(argv[++i]));
+        } else if (arg == "--loadgen" && hasValue) {
+            options.loadgenPath = argv[++i];
+        } else if (arg == "--clients" && hasValue) {
+            options.clients = max(1, atoi(argv[++i]));
+        } else if (arg == "--requests" && hasValue) {
+            options.requests = max(1, atoi(argv[++i]));
+        } else if (arg == "--writes" && hasValue) {
+            options.writePercent = min(100, max(0, atoi(argv[++i])));
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+#ifndef _WIN32
+    if (!options.loadgenPath.empty()) {
+        return LoadGenerator::run(options.loadgenPath, options.clients, options.requests, options.writePercent);
+    }
+#endif
+
+    // Pooled allocation keeps index nodes and posting lists from fragmenting the heap
+    // as records churn; it is synchronized because server workers share it.
+    pmr::synchronized_pool_resource recordPool;
+    Warehouse warehouse(&recordPool);
+    InventoryManager& inventoryManager = warehouse.inventoryManager;
+    MaintenanceRepository& maintenanceRepo = warehouse.maintenanceRepo;
+    ReportRepository& reportRepo = warehouse.reportRepo;
+    ShipmentRepository& shipmentRepo = warehouse.shipmentRepo;
+    SpaceRepository& spaceRepo = warehouse.spaceRepo;
+    if (options.columnar) inventoryManager.enableColumns();
+    uint64_t epoch = 0;
+    if (!recoverWarehouse(warehouse, options, epoch)) {
+        return 1;
+    }
+    if (!options.exportKind.empty()) {
+        if (!exportRecords(warehouse, options.exportKind, options.exportFormat)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return 0;
+    }
+    // Change sequence numbers start at the journal epoch times 2^40, so they keep
+    // increasing across restarts.
+    ChangeStream changes(ChangeStream::DefaultCells, (epoch + 1) << 40);
+    Journal journal;
+    if (!journal.open(options.journalPath, epoch + 1, options.durability, options.syncInterval)) {
+        return 1;
+    }
+    journal.attachChanges(&changes);
+    warehouse.attachJournal(&journal);
+#ifndef _WIN32
+    optional<ChangeTail> tail;
+    if (!options.changesPath.empty()) {
+        tail.emplace(changes, options.changesPath, options.changesToSocket);
+        if (!tail->start()) return 1;
+    }
+#endif
+    JournalCompactor compactor(journal, options.snapshotPath, options.compactBytes);
+    compactor.start();
+
+    if (!options.importPath.empty()) {
+        BulkImporter::Kind kind;
+        BulkImporter::Result result;
+        if (!BulkImporter::parseKind(options.importKind, kind)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        bool imported = BulkImporter::run(warehouse, &journal, kind, options.importPath, options.rejectPath, result);
+        if (imported) {
+            cout << "Imported " << result.Imported << " record(s), rejected " << result.Rejected << " in "
+                 << fixed << setprecision(2) << result.Seconds << " s (" << setprecision(0)
+                 << (result.Imported + result.Rejected) / max(result.Seconds, 1e-9) << " rows/s)." << endl;
+        }
+        return checkpoint(warehouse, journal, compactor, options) && imported ? 0 : 1;
+    }
+#ifndef _WIN32
+    if (!options.servePath.empty()) {
+        return serveWarehouse(warehouse, journal, compactor, options) ? 0 : 1;
+    }
+#endif
     int choice;
 
     do {
@@ -917,6 +8895,7 @@ int main() {
         cout << "3. Report Management" << endl;
         cout << "4. Shipment Management" << endl;
         cout << "5. Space Management" << endl;
+        cout << "6. Metrics" << endl;
         cout << "0. Exit Application" << endl;
         cout << "Enter your choice: ";
         cin >> choice;
@@ -945,7 +8924,13 @@ int main() {
             case 5:
                 spaceRepo.spaceSubMenu();
                 break;
+            case 6:
+                showMetrics(warehouse);
+                break;
             case 0:
+                if (checkpoint(warehouse, journal, compactor, options)) {
+                    cout << "State saved to " << options.snapshotPath << "." << endl;
+                }
                 cout << "Exiting application." << endl;
                 break;
             default: